@@ -0,0 +1,421 @@
+
+// for mkstemp
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <unistd.h>
+
+#include "words_bdd.h"
+
+#define BENCH_ENUM_LIMIT 10000
+#define BENCH_TMP_TEMPLATE "/tmp/words_bdd_benchXXXXXX"
+#define MAX_PARAMS_SIZE 128
+#define ALPHABET_SIZE 26
+#define GRID_RANDOM 'r'
+#define GRID_SYMMETRIC 's'
+#define GRID_LATTICE 'l'
+#define BLACK_SQUARE ' '
+
+
+void processCommandLine(int argc, char **argv);
+WordsBdd *newContext();
+void buildDictionary(WordsBdd *wb, int size);
+void benchPatterns(WordsBdd *wb);
+void benchCrossword(WordsBdd *wb, int size, char kind);
+int countWord(void *data, char *word, double score);
+int countSolution(void *data, 
+                  char (*grid)[MAX_WORD_SIZE][MAX_WORD_SIZE], 
+                  double score);
+void generateWords(FILE *f, int n);
+void generateGrid(FILE *f, int size, double density, char kind);
+void initLetterWeights();
+char sampleLetter();
+int sampleLength();
+FILE *openTmpFile(char *path);
+void startTimer();
+double wallTime();
+void writeResult(char *workload,
+                 char *params,
+                 WordsBdd *wb,
+                 int status,
+                 double count);
+
+int numWords = 20000;
+int minLen = 2;
+int maxLen = 10;
+double meanLen = 6.0;
+double skew = 1.0; // 0 for uniform letters, higher for fewer common letters
+double density = 0.2; // chance of a black square in random grids
+int maxGridSize = 5;
+unsigned int seed = 1;
+char *outFile = 0x00;
+
+FILE *out;
+double letterWeights[ALPHABET_SIZE];
+double startWall;
+clock_t startCpu;
+
+char *benchPatternList[] = {
+    "***", "*****", "a****", "*e**e*", "s*******", 0x00
+};
+
+char gridKinds[] = { GRID_RANDOM, GRID_SYMMETRIC, GRID_LATTICE, 0x00 };
+
+
+/* words_bdd_bench runs a fixed matrix of workloads over synthetic data:
+ *
+ *   build      : wbLoadWords on dictionaries of numWords/100, /10 and
+ *                numWords
+ *   count      : wbCountPattern for each of benchPatternList
+ *   enumerate  : wbMatchPattern / wbSolveCrossword, counting the results
+ *   crossword  : wbCountSolutions on random, symmetric and lattice grids of
+ *                each size from 3 to maxGridSize
+ *
+ * writing one json object per line to outFile (stderr by default).
+ */
+int main(int argc, char **argv) {
+    processCommandLine(argc, argv);
+
+    out = stderr;
+    if (outFile) {
+        out = fopen(outFile, "w");
+        if (!out) {
+            printf("Error opening %s for writing.\n", outFile);
+            exit(-1);
+        }
+    }
+
+    srand(seed);
+    initLetterWeights();
+
+    for (int size = numWords / 100; size < numWords; size *= 10) {
+        WordsBdd *wb = newContext();
+        buildDictionary(wb, size);
+        wbFree(wb);
+    }
+
+    WordsBdd *wb = newContext();
+    buildDictionary(wb, numWords);
+
+    benchPatterns(wb);
+
+    for (int size = 3; size <= maxGridSize; ++size) {
+        for (int k = 0; gridKinds[k]; ++k)
+            benchCrossword(wb, size, gridKinds[k]);
+    }
+
+    wbFree(wb);
+
+    if (outFile)
+        fclose(out);
+}
+
+
+void processCommandLine(int argc, char **argv) {
+    int i = 1;
+    int help = 0;
+    int error = 0;
+
+    while (i < argc && !error && !help) {
+        if (strcmp(argv[i], "-h") == 0) {
+            help = 1;
+            ++i;
+        } else if (i == argc - 1) {
+            error = 1;
+        } else if (strcmp(argv[i], "-n") == 0) {
+            numWords = atoi(argv[i+1]);
+            error = (numWords < 100);
+            i += 2;
+        } else if (strcmp(argv[i], "-minlen") == 0) {
+            minLen = atoi(argv[i+1]);
+            i += 2;
+        } else if (strcmp(argv[i], "-maxlen") == 0) {
+            maxLen = atoi(argv[i+1]);
+            i += 2;
+        } else if (strcmp(argv[i], "-meanlen") == 0) {
+            meanLen = atof(argv[i+1]);
+            i += 2;
+        } else if (strcmp(argv[i], "-skew") == 0) {
+            skew = atof(argv[i+1]);
+            i += 2;
+        } else if (strcmp(argv[i], "-density") == 0) {
+            density = atof(argv[i+1]);
+            i += 2;
+        } else if (strcmp(argv[i], "-grid") == 0) {
+            maxGridSize = atoi(argv[i+1]);
+            error = (maxGridSize >= MAX_WORD_SIZE);
+            i += 2;
+        } else if (strcmp(argv[i], "-seed") == 0) {
+            seed = strtoul(argv[i+1], 0x00, 10);
+            i += 2;
+        } else if (strcmp(argv[i], "-o") == 0) {
+            outFile = argv[i+1];
+            i += 2;
+        } else {
+            ++i;
+        }
+    }
+
+    error = error ||
+            minLen < 1 ||
+            maxLen >= MAX_WORD_SIZE ||
+            minLen > maxLen ||
+            meanLen < minLen ||
+            meanLen > maxLen;
+
+    if (error || help) {
+        printf("Usage: ./words_bdd_bench [options]\n");
+        printf("\n");
+        printf("options:\n");
+        printf("    -n <n>         : words in largest dictionary (default %d)\n",
+               numWords);
+        printf("    -minlen <n>    : shortest word (default %d)\n", minLen);
+        printf("    -maxlen <n>    : longest word (default %d)\n", maxLen);
+        printf("    -meanlen <x>   : mean word length (default %g)\n", meanLen);
+        printf("    -skew <x>      : zipf exponent of letter frequencies\n");
+        printf("                     (default %g, 0 is uniform)\n", skew);
+        printf("    -density <x>   : black square density of random grids\n");
+        printf("                     (default %g)\n", density);
+        printf("    -grid <n>      : largest grid size (default %d)\n",
+               maxGridSize);
+        printf("    -seed <n>      : random seed (default %u)\n", seed);
+        printf("    -o <file>      : write results to file (default stderr)\n");
+        printf("    -h             : this help\n");
+        exit(-1);
+    }
+}
+
+
+WordsBdd *newContext() {
+    WordsBdd *wb = wbNew(0, CUDD_UNIQUE_SLOTS, CUDD_CACHE_SLOTS);
+    if (wb == 0x00) {
+        fprintf(stderr, "Could not create bdd manager.\n");
+        exit(RESOURCE_LIMIT_STATUS);
+    }
+    return wb;
+}
+
+
+void buildDictionary(WordsBdd *wb, int size) {
+    char path[] = BENCH_TMP_TEMPLATE;
+    FILE *f = openTmpFile(path);
+    generateWords(f, size);
+    fclose(f);
+
+    char params[MAX_PARAMS_SIZE];
+    sprintf(params, "words=%d", size);
+
+    startTimer();
+    int status = wbLoadWords(wb, DEFAULT_DICT_NAME, path, 0);
+    writeResult("build", params, wb, status, wb->totalWords);
+
+    unlink(path);
+
+    if (status != WB_OK) {
+        fprintf(stderr, "%s\n", wbError(wb));
+        exit(-1);
+    }
+}
+
+
+void benchPatterns(WordsBdd *wb) {
+    for (int i = 0; benchPatternList[i]; ++i) {
+        char *pattern = benchPatternList[i];
+        char params[MAX_PARAMS_SIZE];
+        sprintf(params, "pattern=%s", pattern);
+
+        double count = -1;
+        startTimer();
+        int status = wbCountPattern(wb, pattern, &count);
+        writeResult("count", params, wb, status, count);
+
+        double found = 0;
+        startTimer();
+        status = wbMatchPattern(wb, pattern, 0, countWord, &found);
+        writeResult("enumerate", params, wb, status, found);
+    }
+}
+
+
+void benchCrossword(WordsBdd *wb, int size, char kind) {
+    char path[] = BENCH_TMP_TEMPLATE;
+    FILE *f = openTmpFile(path);
+    generateGrid(f, size, density, kind);
+    fclose(f);
+
+    Crossword cw;
+    int status = wbReadCrossword(wb, path, 0, &cw);
+    unlink(path);
+    if (status != WB_OK) {
+        fprintf(stderr, "%s\n", wbError(wb));
+        exit(-1);
+    }
+
+    char params[MAX_PARAMS_SIZE];
+    sprintf(params, "grid=%dx%d kind=%c clues=%d", size, size, kind, cw.size);
+
+    double count = -1;
+    startTimer();
+    status = wbCountSolutions(wb, &cw, &count);
+    writeResult("crossword", params, wb, status, count);
+
+    if (status == WB_OK && count <= BENCH_ENUM_LIMIT) {
+        double found = 0;
+        startTimer();
+        status = wbSolveCrossword(wb, &cw, 0, countSolution, &found);
+        writeResult("enumerate", params, wb, status, found);
+    }
+
+    wbFreeCrossword(&cw);
+}
+
+int countWord(void *data, char *word, double score) {
+    (*(double*)data)++;
+    return 0;
+}
+
+int countSolution(void *data, 
+                  char (*grid)[MAX_WORD_SIZE][MAX_WORD_SIZE], 
+                  double score) {
+    (*(double*)data)++;
+    return 0;
+}
+
+
+void generateWords(FILE *f, int n) {
+    char word[MAX_WORD_SIZE];
+
+    for (int i = 0; i < n; ++i) {
+        int len = sampleLength();
+        for (int j = 0; j < len; ++j)
+            word[j] = sampleLetter();
+        word[len] = 0x00;
+        fprintf(f, "%s\n", word);
+    }
+}
+
+/* generateGrid(f, size, density, kind)
+ *
+ * Writes a size x size diagram of empty squares to f, with black squares
+ * placed at random with the given density (GRID_RANDOM), the same with
+ * rotational symmetry (GRID_SYMMETRIC), or at every odd row and column
+ * (GRID_LATTICE).
+ */
+void generateGrid(FILE *f, int size, double density, char kind) {
+    char grid[MAX_WORD_SIZE][MAX_WORD_SIZE];
+
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            // the rotation of (x, y) was placed first if it comes earlier
+            int mirrorFirst = (y*size + x) > ((size-1-y)*size + (size-1-x));
+            int black;
+            if (kind == GRID_LATTICE)
+                black = (x % 2 == 1 && y % 2 == 1);
+            else if (kind == GRID_SYMMETRIC && mirrorFirst)
+                black = (grid[size - 1 - x][size - 1 - y] == BLACK_SQUARE);
+            else
+                black = ((double)rand() / RAND_MAX < density);
+            grid[x][y] = black ? BLACK_SQUARE : ANY_CHAR;
+        }
+    }
+
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x)
+            fputc(grid[x][y], f);
+        fputc('\n', f);
+    }
+}
+
+
+/* initLetterWeights()
+ *
+ * Letters are ranked in english frequency order and given zipf weights
+ * 1/rank^skew, stored cumulatively.
+ */
+void initLetterWeights() {
+    double total = 0;
+    for (int i = 0; i < ALPHABET_SIZE; ++i) {
+        total += 1.0 / pow(i + 1, skew);
+        letterWeights[i] = total;
+    }
+    for (int i = 0; i < ALPHABET_SIZE; ++i)
+        letterWeights[i] /= total;
+}
+
+char sampleLetter() {
+    static const char *byFrequency = "etaoinshrdlcumwfgypbvkjxqz";
+    double r = (double)rand() / RAND_MAX;
+    int i = 0;
+    while (i < ALPHABET_SIZE - 1 && letterWeights[i] < r)
+        ++i;
+    return byFrequency[i];
+}
+
+/* sampleLength()
+ *
+ * Binomially distributed between minLen and maxLen with mean meanLen.
+ */
+int sampleLength() {
+    int trials = maxLen - minLen;
+    double p = (trials > 0) ? (meanLen - minLen) / trials : 0;
+    int len = minLen;
+    for (int i = 0; i < trials; ++i) {
+        if ((double)rand() / RAND_MAX < p)
+            ++len;
+    }
+    return len;
+}
+
+
+FILE *openTmpFile(char *path) {
+    int fd = mkstemp(path);
+    FILE *f = (fd >= 0) ? fdopen(fd, "w") : 0x00;
+    if (!f) {
+        fprintf(stderr, "Could not create temporary file %s.\n", path);
+        exit(-1);
+    }
+    return f;
+}
+
+
+void startTimer() {
+    startWall = wallTime();
+    startCpu = clock();
+}
+
+double wallTime() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* writeResult(workload, params, wb, status, count)
+ *
+ * Writes the time since startTimer and the node counts of wb, or that the
+ * workload failed if status is not WB_OK.  count is -1 if not known.
+ */
+void writeResult(char *workload,
+                 char *params,
+                 WordsBdd *wb,
+                 int status,
+                 double count) {
+    DdManager *manager = wb->manager;
+
+    double wall = wallTime() - startWall;
+    double cpu = (double)(clock() - startCpu) / CLOCKS_PER_SEC;
+
+    fprintf(out, "{\"workload\": \"%s\", \"params\": \"%s\", "
+                 "\"wall\": %f, \"cpu\": %f, ",
+            workload, params, wall, cpu);
+    if (status == WB_OK && wb->dict)
+        fprintf(out, "\"dictSize\": %d, ", Cudd_DagSize(wb->dict));
+    else if (status != WB_OK)
+        fprintf(out, "\"failed\": true, ");
+    fprintf(out, "\"count\": %.0f, \"liveNodes\": %ld, "
+                 "\"peakLiveNodes\": %d, \"memoryInUse\": %lu}\n",
+            count,
+            Cudd_ReadNodeCount(manager),
+            Cudd_ReadPeakLiveNodeCount(manager),
+            Cudd_ReadMemoryInUse(manager));
+    fflush(out);
+}
@@ -0,0 +1,3364 @@
+
+// for clock_gettime
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "words_bdd_internal.h"
+
+
+/* Every wb* function sets wb->onError on entry, so that failures deep inside
+ * (fail, checkedRef) can return straight to it with an error status.  They
+ * should not call each other.  Anything held across a call that may fail is
+ * registered with pushCleanup (or pushRef) first, so fail can release it.
+ */
+
+/* wbNew(maxMemory, uniqueSlots, cacheSlots)
+ *
+ * Returns a new context, or null if cudd could not start.  Sets cudd's
+ * process-wide MMoutOfMemory handler to Cudd_OutOfMem, so any cudd manager
+ * in the process returns null rather than exiting when out of memory.
+ */
+WordsBdd *wbNew(unsigned long maxMemory, 
+                unsigned int uniqueSlots, 
+                unsigned int cacheSlots) {
+    // have cudd return null when an allocation fails rather than exit
+    MMoutOfMemory = Cudd_OutOfMem;
+
+    WordsBdd *wb = (WordsBdd*)calloc(1, sizeof(WordsBdd));
+    if (wb == 0x00)
+        return 0x00;
+
+    wb->manager = Cudd_Init(0,0,uniqueSlots,cacheSlots,maxMemory);
+    if (wb->manager == 0x00) {
+        free(wb);
+        return 0x00;
+    }
+    if (maxMemory)
+        Cudd_SetMaxLive(wb->manager, maxMemory / BYTES_PER_NODE);
+    wb->compress = 1;
+    wb->foldCase = 1;
+    wb->minLength = 1;
+    wb->maxLength = MAX_WORD_SIZE - 1;
+
+    return wb;
+}
+
+void wbFree(WordsBdd *wb) {
+    Cudd_Quit(wb->manager);
+    free(wb);
+}
+
+/* wbLoadWords(wb, name, wordsFile, withScores)
+ *
+ * Adds the language called name from a word file.  If withScores, its scores
+ * become the word scores.  The first language loaded is used for queries
+ * until wbUseDict is called.
+ */
+int wbLoadWords(WordsBdd *wb, char *name, char *wordsFile, int withScores) {
+    if (setjmp(wb->onError))
+        return wb->status;
+
+    DdNode *scores = 0x00;
+
+    beginPhase(wb, "build");
+    DdNode *dict = loadWords(wb, wordsFile, withScores ? &scores : 0x00);
+    endPhase(wb);
+
+    pushRef(wb, &scores);
+    addNamedDict(wb, name, dict);
+    popCleanups(wb, 1);
+    if (scores) {
+        setScores(wb, scores);
+        coverScores(wb);
+    }
+
+    return WB_OK;
+}
+
+int wbLoadBdd(WordsBdd *wb, char *name, char *bddFile) {
+    if (setjmp(wb->onError))
+        return wb->status;
+
+    beginPhase(wb, "load");
+    DdNode *dict = loadBdd(wb, bddFile);
+    endPhase(wb);
+
+    addNamedDict(wb, name, dict);
+
+    return WB_OK;
+}
+
+int wbLoadScores(WordsBdd *wb, char *scoresFile) {
+    if (setjmp(wb->onError))
+        return wb->status;
+
+    setScores(wb, loadScores(wb, scoresFile));
+    coverScores(wb);
+
+    return WB_OK;
+}
+
+/* wbUseDict(wb, expr)
+ *
+ * Runs later queries against the language given by expr (see evalDictExpr).
+ */
+int wbUseDict(WordsBdd *wb, char *expr) {
+    if (setjmp(wb->onError))
+        return wb->status;
+
+    beginPhase(wb, "expression");
+    wb->dict = evalDictExpr(wb, expr);
+    endPhase(wb);
+
+    // default scores were for the old dictionary, so make them again lazily
+    if (wb->defaultScores)
+        setScores(wb, 0x00);
+    coverScores(wb);
+
+    return WB_OK;
+}
+
+int wbSaveBdd(WordsBdd *wb, char *bddFile) {
+    if (setjmp(wb->onError))
+        return wb->status;
+
+    writeBddDict(wb, getDict(wb), bddFile);
+
+    return WB_OK;
+}
+
+int wbSaveScores(WordsBdd *wb, char *scoresFile) {
+    if (setjmp(wb->onError))
+        return wb->status;
+
+    writeScores(wb, getScores(wb), scoresFile);
+
+    return WB_OK;
+}
+
+int wbSaveDot(WordsBdd *wb, char *dotFile) {
+    if (setjmp(wb->onError))
+        return wb->status;
+
+    writeDotDict(wb, getDict(wb), dotFile);
+
+    return WB_OK;
+}
+
+/* wbMatchPattern(wb, pattern, topK, callback, data)
+ *
+ * Calls callback with each word matching pattern, or only the topK highest
+ * scoring ones (best first) if topK > 0.
+ */
+int wbMatchPattern(WordsBdd *wb, 
+                   char *pattern, 
+                   int topK, 
+                   WordCallback callback, 
+                   void *data) {
+    if (setjmp(wb->onError))
+        return wb->status;
+
+    beginPhase(wb, "pattern");
+    DdNode *match = matchPattern(wb, getDict(wb), pattern);
+    endPhase(wb);
+
+    pushRef(wb, &match);
+    beginPhase(wb, "enumerate");
+    enumerateMatches(wb, match, topK, callback, data);
+    endPhase(wb);
+    popCleanups(wb, 1);
+
+    Cudd_RecursiveDeref(wb->manager, match);
+
+    return WB_OK;
+}
+
+int wbMatchFuzzy(WordsBdd *wb, 
+                 char *word, 
+                 int topK, 
+                 WordCallback callback, 
+                 void *data) {
+    if (setjmp(wb->onError))
+        return wb->status;
+
+    beginPhase(wb, "fuzzy");
+    DdNode *match = matchFuzzy(wb, getDict(wb), word);
+    endPhase(wb);
+
+    pushRef(wb, &match);
+    beginPhase(wb, "enumerate");
+    enumerateMatches(wb, match, topK, callback, data);
+    endPhase(wb);
+    popCleanups(wb, 1);
+
+    Cudd_RecursiveDeref(wb->manager, match);
+
+    return WB_OK;
+}
+
+int wbCountPattern(WordsBdd *wb, char *pattern, double *count) {
+    if (setjmp(wb->onError))
+        return wb->status;
+
+    beginPhase(wb, "pattern");
+    DdNode *match = matchPattern(wb, getDict(wb), pattern);
+    *count = countWords(wb, match, strlen(pattern));
+    endPhase(wb);
+
+    Cudd_RecursiveDeref(wb->manager, match);
+
+    return WB_OK;
+}
+
+int wbReadCrossword(WordsBdd *wb, 
+                    char *crosswordFile, 
+                    int rawFormat, 
+                    Crossword *cw) {
+    if (setjmp(wb->onError))
+        return wb->status;
+
+    *cw = readCrossword(wb, crosswordFile, rawFormat);
+
+    return WB_OK;
+}
+
+/* wbSolveCrossword(wb, cw, topK, callback, data)
+ *
+ * Calls callback with each solution of cw, or only the topK highest scoring
+ * ones (best first) if topK > 0.
+ */
+int wbSolveCrossword(WordsBdd *wb, 
+                     Crossword *cw, 
+                     int topK, 
+                     SolutionCallback callback, 
+                     void *data) {
+    if (setjmp(wb->onError))
+        return wb->status;
+
+    solveCrossword(wb, getDict(wb), cw, topK, callback, data);
+
+    return WB_OK;
+}
+
+int wbCountSolutions(WordsBdd *wb, Crossword *cw, double *count) {
+    if (setjmp(wb->onError))
+        return wb->status;
+
+    DdNode *cwBdd = encodeCrossword(wb, getDict(wb), cw, 0x00);
+    if (cwBdd == 0x00)
+        resourceLimit(wb);
+
+    // cwBdd only depends on the relevant vars
+    int nvars = Cudd_ReadSize(wb->manager);
+    int *mask = getRelevanceMask(cw, nvars);
+    int relevant = 0;
+    for (int i = 0; i < nvars; ++i)
+        relevant += mask[i];
+    free(mask);
+
+    // counting over all vars would overflow cudd's 2^nvars
+    *count = Cudd_CountMinterm(wb->manager, cwBdd, relevant);
+
+    Cudd_RecursiveDeref(wb->manager, cwBdd);
+
+    return WB_OK;
+}
+
+/* wbFillCrossword(wb, cw, seconds, maxFills, callback, data)
+ *
+ * Calls callback with fills of the empty squares of cw found by search (see
+ * fillCrossword), giving up after maxFills fills or seconds if not 0.
+ */
+int wbFillCrossword(WordsBdd *wb, 
+                    Crossword *cw, 
+                    double seconds,
+                    int maxFills,
+                    SolutionCallback callback, 
+                    void *data) {
+    if (setjmp(wb->onError))
+        return wb->status;
+
+    fillCrossword(wb, getDict(wb), cw, seconds, maxFills, callback, data);
+
+    return WB_OK;
+}
+
+void wbFreeCrossword(Crossword *cw) {
+    free(cw->clues);
+}
+
+char *wbError(WordsBdd *wb) {
+    return wb->error;
+}
+
+
+/* fail(wb, status, format, ...)
+ *
+ * Records the error message and returns to the calling wb* function, which
+ * returns status.
+ */
+static void fail(WordsBdd *wb, int status, char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vsnprintf(wb->error, MAX_ERROR_SIZE, format, args);
+    va_end(args);
+
+    // newest first, as each was registered after what it depends on
+    while (wb->numCleanups > 0) {
+        Cleanup *c = &wb->cleanups[--wb->numCleanups];
+        c->function(wb, c->arg);
+    }
+
+    wb->status = status;
+    longjmp(wb->onError, 1);
+}
+
+/* pushCleanup(wb, function, arg)
+ *
+ * Registers function(wb, arg) to free something the caller holds if the
+ * current wb* call fails, until the caller pops it with popCleanups.
+ */
+static void pushCleanup(WordsBdd *wb, CleanupFunction function, void *arg) {
+    if (wb->numCleanups >= MAX_CLEANUPS) {
+        function(wb, arg);
+        fail(wb, WB_RESOURCE_LIMIT, "Resource limit: too many cleanups.");
+    }
+    wb->cleanups[wb->numCleanups].function = function;
+    wb->cleanups[wb->numCleanups].arg = arg;
+    wb->numCleanups++;
+}
+
+/* pushRef(wb, node)
+ *
+ * Registers *node (a referenced bdd or null) to be dereferenced on failure.
+ * node is read at failure time, so it can be updated meanwhile.
+ */
+static void pushRef(WordsBdd *wb, DdNode **node) {
+    pushCleanup(wb, derefCleanup, node);
+}
+
+static void popCleanups(WordsBdd *wb, int n) {
+    wb->numCleanups -= n;
+}
+
+static void derefCleanup(WordsBdd *wb, void *node) {
+    DdNode **n = (DdNode**)node;
+    if (*n)
+        Cudd_RecursiveDeref(wb->manager, *n);
+}
+
+static void freeCleanup(WordsBdd *wb, void *p) {
+    free(p);
+}
+
+static void logMsg(WordsBdd *wb, char *format, ...) {
+    if (!wb->log)
+        return;
+
+    va_list args;
+    va_start(args, format);
+    vfprintf(wb->log, format, args);
+    va_end(args);
+}
+
+static DdNode *getDict(WordsBdd *wb) {
+    if (wb->dict == 0x00)
+        fail(wb, WB_ERROR, "No dictionary loaded.");
+    return wb->dict;
+}
+
+/* getScores(wb)
+ *
+ * The word scores, scoring every word of the dictionary 0 if none were given.
+ */
+static DdNode *getScores(WordsBdd *wb) {
+    if (wb->scores == 0x00) {
+        wb->scores = getDefaultScores(wb, getDict(wb));
+        wb->defaultScores = 1;
+    }
+    return wb->scores;
+}
+
+static void setScores(WordsBdd *wb, DdNode *scores) {
+    if (wb->scores)
+        Cudd_RecursiveDeref(wb->manager, wb->scores);
+    wb->scores = scores;
+    wb->defaultScores = 0;
+}
+
+/* coverScores(wb)
+ *
+ * Scores the words of the dictionary that have no score 0, so that words
+ * from other languages (say with -e) are not left out of rankings.
+ */
+static void coverScores(WordsBdd *wb) {
+    DdManager *manager = wb->manager;
+
+    if (wb->scores == 0x00 || wb->dict == 0x00)
+        return;
+
+    CUDD_VALUE_TYPE minusInf = Cudd_V(Cudd_ReadMinusInfinity(manager));
+    DdNode *scored = Cudd_addBddStrictThreshold(manager, wb->scores, minusInf);
+    checkedRef(wb, scored);
+    pushRef(wb, &scored);
+    DdNode *missing = Cudd_bddAnd(manager, wb->dict, Cudd_Not(scored));
+    checkedRef(wb, missing);
+    popCleanups(wb, 1);
+    Cudd_RecursiveDeref(manager, scored);
+
+    pushRef(wb, &missing);
+    DdNode *missingScores = getDefaultScores(wb, missing);
+    popCleanups(wb, 1);
+    Cudd_RecursiveDeref(manager, missing);
+
+    pushRef(wb, &missingScores);
+    DdNode *tmp = Cudd_addApply(manager, 
+                                Cudd_addMaximum, 
+                                wb->scores, 
+                                missingScores);
+    checkedRef(wb, tmp);
+    popCleanups(wb, 1);
+    Cudd_RecursiveDeref(manager, missingScores);
+    setScores(wb, tmp);
+}
+
+
+static DdNode *addWord(WordsBdd *wb, DdNode *dict, char *word) {
+    DdManager *manager = wb->manager;
+
+    DdNode *bddWord = getWord(wb, word);
+    pushRef(wb, &bddWord);
+
+    DdNode *newDict = Cudd_bddOr(manager, dict, bddWord);
+    checkedRef(wb, newDict);
+    popCleanups(wb, 1);
+    Cudd_RecursiveDeref(manager, bddWord);
+
+    return newDict;
+}
+
+
+static DdNode *getWord(WordsBdd *wb, char* word) {
+    DdManager *manager = wb->manager;
+
+    DdNode *bddWord = Cudd_ReadOne(manager);
+    Cudd_Ref(bddWord);
+    pushRef(wb, &bddWord);
+
+    DdNode *tmp;
+    int i;
+
+    for (i = 0; word[i] != 0x00; ++i) {
+        tmp = addChar(wb, bddWord, word[i], i);
+        Cudd_RecursiveDeref(manager, bddWord);
+        bddWord = tmp;
+    }
+
+    tmp = addChar(wb, bddWord, 0x00, i);
+    Cudd_RecursiveDeref(manager, bddWord);
+    bddWord = tmp;
+
+    popCleanups(wb, 1);
+    return bddWord;
+}
+
+static DdNode *getWordWildcards(WordsBdd *wb, char* word) {
+    DdManager *manager = wb->manager;
+
+    DdNode *bddWord = Cudd_ReadOne(manager);
+    Cudd_Ref(bddWord);
+    pushRef(wb, &bddWord);
+
+    DdNode *tmp;
+    int i;
+
+    for (i = 0; word[i] != 0x00; ++i) {
+        if (word[i] != ANY_CHAR) {
+            tmp = addChar(wb, bddWord, word[i], i);
+            Cudd_RecursiveDeref(manager, bddWord);
+            bddWord = tmp;
+        } else {
+            tmp = addNonNull(wb, bddWord, i);
+            Cudd_RecursiveDeref(manager, bddWord);
+            bddWord = tmp;
+        }
+    }
+
+    tmp = addChar(wb, bddWord, 0x00, i);
+    Cudd_RecursiveDeref(manager, bddWord);
+    bddWord = tmp;
+
+    popCleanups(wb, 1);
+    return bddWord;
+}
+
+static DdNode *addChar(WordsBdd *wb, DdNode *bddWord, char c, int i) {
+    DdManager *manager = wb->manager;
+
+    DdNode *b, *newWord; 
+
+    newWord = bddWord;
+    Cudd_Ref(newWord);
+    pushRef(wb, &newWord);
+
+    for (int bit = 0; bit < 8; ++bit) {
+        b = Cudd_bddIthVar(manager, 8*i + bit);
+
+        DdNode *tmp;
+        if (c & (1<<bit))
+            tmp = Cudd_bddAnd(manager, b, newWord);               
+        else 
+            tmp = Cudd_bddAnd(manager, Cudd_Not(b), newWord);
+        checkedRef(wb, tmp);
+        Cudd_RecursiveDeref(manager, newWord);
+        newWord = tmp;
+    }
+    
+    popCleanups(wb, 1);
+    return newWord;
+}
+
+static DdNode *addNonNull(WordsBdd *wb, DdNode *bddWord, int i) {
+    DdManager *manager = wb->manager;
+
+    DdNode *b, *anyChar, *newWord; 
+
+    anyChar = Cudd_ReadLogicZero(manager);
+    Cudd_Ref(anyChar);
+    pushRef(wb, &anyChar);
+
+    for (int bit = 0; bit < 8; ++bit) {
+        b = Cudd_bddIthVar(manager, 8*i + bit);
+
+        DdNode *tmp = Cudd_bddOr(manager, b, anyChar);
+        checkedRef(wb, tmp);
+        Cudd_RecursiveDeref(manager, anyChar);
+        anyChar = tmp;
+    }
+
+    newWord = Cudd_bddAnd(manager, bddWord, anyChar);
+    checkedRef(wb, newWord);
+    popCleanups(wb, 1);
+    Cudd_RecursiveDeref(manager, anyChar);
+    
+    return newWord;
+}
+
+
+static void writeDotDict(WordsBdd *wb, DdNode *dict, char *outFile) {
+    DdManager *manager = wb->manager;
+
+    DdNode *outputs[] = { dict };
+    FILE *f = fopen(outFile, "w");
+    if (!f)
+        fail(wb, WB_ERROR, "Error opening %s for writing.", outFile);
+    Cudd_DumpDot(manager, 1, outputs, NULL, NULL, f);
+    fclose(f);
+}
+
+
+/* loadWords(wb, wordsFile, scores)
+ *
+ * Reads one word per line, optionally followed by a score.  If scores is not
+ * null, *scores is set to an add mapping each word to its score (0 if none was
+ * given, the max if a word appears twice) and every other string to -infinity.
+ *
+ * The file (gzip'd or not, "-" for stdin) is read in large chunks and split
+ * into lines in place, so lines can be any length.  Words may contain spaces,
+ * only a last field that is a number is taken as the score.  Words are
+ * normalized as set in wb (see normalizeWord), and skipped if too long or
+ * short.  They are added to the dictionary a batch at a time.
+ */
+static DdNode *loadWords(WordsBdd *wb, char *wordsFile, DdNode **scores) {
+    DdManager *manager = wb->manager;
+
+    gzFile f = (strcmp(wordsFile, STDIN_FILE) == 0)
+             ? gzdopen(dup(fileno(stdin)), "rb")
+             : gzopen(wordsFile, "rb");
+    if (!f)
+        fail(wb, WB_ERROR, "Could not open %s for reading.", wordsFile);
+    pushCleanup(wb, closeWordsCleanup, f);
+    gzbuffer(f, INGEST_CHUNK_SIZE);
+
+    WordBatch *batch = (WordBatch*)malloc(sizeof(WordBatch));
+    pushCleanup(wb, freeCleanup, batch);
+    // room for a 0x00 after a line that fills the chunk
+    char *chunk = (char*)malloc(INGEST_CHUNK_SIZE + 1);
+    pushCleanup(wb, freeCleanup, chunk);
+    if (!batch || !chunk)
+        fail(wb, WB_ERROR, "Out of memory reading %s.", wordsFile);
+    batch->size = 0;
+    batch->scores = scores;
+
+    batch->dict = Cudd_ReadLogicZero(manager);
+    Cudd_Ref(batch->dict);
+    pushRef(wb, &batch->dict);
+
+    if (scores) {
+        *scores = Cudd_ReadMinusInfinity(manager);
+        Cudd_Ref(*scores);
+        pushRef(wb, scores);
+    }
+
+    long skipped = 0;
+    long filled = 0; // bytes in chunk
+    int longLine = 0; // = 1 if dropping the rest of a line too long to hold
+    int len;
+
+    while ((len = gzread(f, chunk + filled, INGEST_CHUNK_SIZE - filled)) > 0) {
+        filled += len;
+
+        char *line = chunk;
+        char *end = chunk + filled;
+        char *nl;
+        while ((nl = memchr(line, '\n', end - line))) {
+            if (longLine)
+                longLine = 0;
+            else
+                skipped += !addLine(wb, batch, line, nl - line);
+            line = nl + 1;
+        }
+
+        filled = end - line;
+        if (filled == INGEST_CHUNK_SIZE) {
+            // no word is this long, so drop it
+            if (!longLine)
+                skipped++;
+            longLine = 1;
+            filled = 0;
+        } else {
+            memmove(chunk, line, filled);
+        }
+    }
+
+    if (len < 0)
+        fail(wb, WB_ERROR, "Error reading %s.", wordsFile);
+    if (filled > 0 && !longLine)
+        skipped += !addLine(wb, batch, chunk, filled);
+
+    addWordBatch(wb, batch);
+    DdNode *dict = batch->dict;
+
+    popCleanups(wb, scores ? 5 : 4);
+    gzclose(f);
+    free(chunk);
+    free(batch);
+
+    if (skipped > 0)
+        logMsg(wb, "%ld lines skipped.\n", skipped);
+    writeSummary(wb, dict);
+
+    return dict;
+}
+
+static void closeWordsCleanup(WordsBdd *wb, void *f) {
+    gzclose((gzFile)f);
+}
+
+/* addLine(wb, batch, line, len)
+ *
+ * Adds the word (and score) on line, of len chars, to batch.  line[len] is
+ * overwritten.  Returns 0 if the line was skipped, 1 otherwise (including
+ * blank lines).
+ */
+static int addLine(WordsBdd *wb, WordBatch *batch, char *line, long len) {
+    line[len] = 0x00;
+
+    // trim, and take a last field that is a number as the score
+    long start = 0;
+    while (start < len && isspace((unsigned char)line[start]))
+        start++;
+    while (len > start && isspace((unsigned char)line[len - 1]))
+        line[--len] = 0x00;
+    if (start == len)
+        return 1;
+
+    double score = 0.0;
+    long field = len;
+    while (field > start && !isspace((unsigned char)line[field - 1]))
+        field--;
+    if (field > start) {
+        char *scoreEnd;
+        double value = strtod(line + field, &scoreEnd);
+        if (*scoreEnd == 0x00) {
+            score = value;
+            len = field;
+            while (len > start && isspace((unsigned char)line[len - 1]))
+                len--;
+        }
+    }
+
+    char *word = batch->words[batch->size];
+    if (!normalizeWord(wb, line + start, len - start, word))
+        return 0;
+
+    int wordLen = strlen(word);
+    if (wordLen < wb->minLength || wordLen > wb->maxLength)
+        return 0;
+
+    wb->totalChars += wordLen;
+    wb->totalWords++;
+
+    batch->wordScores[batch->size++] = score;
+    if (batch->size == WORD_BATCH_SIZE)
+        addWordBatch(wb, batch);
+
+    return 1;
+}
+
+/* normalizeWord(wb, raw, len, word)
+ *
+ * Writes raw (of len chars) to word, folding case, replacing accented latin
+ * letters (in utf-8) by plain ones and dropping punctuation if wb says to.
+ * Returns 0 if the result would not fit in MAX_WORD_SIZE.
+ */
+static int normalizeWord(WordsBdd *wb, char *raw, long len, char *word) {
+    // U+00C0 to U+00FF without accents, 0x00 to drop (for x and / signs)
+    static const char *latin1 = 
+        "AAAAAAACEEEEIIIIDNOOOOO\0OUUUUYTs"
+        "aaaaaaaceeeeiiiidnooooo\0ouuuuyty";
+
+    int n = 0;
+    for (long i = 0; i < len; ++i) {
+        unsigned char c = raw[i];
+
+        if (wb->stripAccents && 
+            (c == 0xc3) && 
+            i + 1 < len && 
+            ((unsigned char)raw[i + 1] & 0xc0) == 0x80) {
+            c = latin1[(unsigned char)raw[++i] - 0x80];
+            if (c == 0x00)
+                continue;
+        }
+
+        if (wb->stripPunct && ispunct(c))
+            continue;
+        if (wb->foldCase && c < 0x80)
+            c = tolower(c);
+
+        if (n >= MAX_WORD_SIZE - 1)
+            return 0;
+        word[n++] = c;
+    }
+    word[n] = 0x00;
+
+    return 1;
+}
+
+/* addWordBatch(wb, batch)
+ *
+ * Adds the words in batch to batch->dict (and scores), and empties it.  The
+ * words are or'd together pairwise first, so most ors are between small
+ * bdds, rather than each one with the whole dictionary.  Their score adds
+ * are combined the same way.
+ */
+static void addWordBatch(WordsBdd *wb, WordBatch *batch) {
+    DdManager *manager = wb->manager;
+
+    DdNode *bdds[WORD_BATCH_SIZE];
+    DdNode *adds[WORD_BATCH_SIZE]; // scores, if wanted
+    int n = batch->size;
+
+    memset(bdds, 0, sizeof(bdds));
+    pushCleanup(wb, derefBatchCleanup, bdds);
+    memset(adds, 0, sizeof(adds));
+    pushCleanup(wb, derefBatchCleanup, adds);
+
+    for (int i = 0; i < n; ++i) {
+        bdds[i] = getWord(wb, batch->words[i]);
+        if (batch->scores)
+            adds[i] = getWordScore(wb, bdds[i], batch->wordScores[i]);
+    }
+
+    for (int step = 1; step < n; step *= 2) {
+        for (int i = 0; i + step < n; i += 2*step) {
+            DdNode *tmp = Cudd_bddOr(manager, bdds[i], bdds[i + step]);
+            checkedRef(wb, tmp);
+            Cudd_RecursiveDeref(manager, bdds[i]);
+            Cudd_RecursiveDeref(manager, bdds[i + step]);
+            bdds[i] = tmp;
+            bdds[i + step] = 0x00;
+
+            if (batch->scores) {
+                tmp = Cudd_addApply(manager, 
+                                    Cudd_addMaximum, 
+                                    adds[i], 
+                                    adds[i + step]);
+                checkedRef(wb, tmp);
+                Cudd_RecursiveDeref(manager, adds[i]);
+                Cudd_RecursiveDeref(manager, adds[i + step]);
+                adds[i] = tmp;
+                adds[i + step] = 0x00;
+            }
+        }
+    }
+
+    if (n > 0) {
+        DdNode *tmp = Cudd_bddOr(manager, batch->dict, bdds[0]);
+        checkedRef(wb, tmp);
+        Cudd_RecursiveDeref(manager, batch->dict);
+        Cudd_RecursiveDeref(manager, bdds[0]);
+        batch->dict = tmp;
+        bdds[0] = 0x00;
+
+        if (batch->scores) {
+            tmp = Cudd_addApply(manager, 
+                                Cudd_addMaximum, 
+                                *batch->scores, 
+                                adds[0]);
+            checkedRef(wb, tmp);
+            Cudd_RecursiveDeref(manager, *batch->scores);
+            Cudd_RecursiveDeref(manager, adds[0]);
+            *batch->scores = tmp;
+        }
+    }
+
+    popCleanups(wb, 2);
+    batch->size = 0;
+}
+
+static void derefBatchCleanup(WordsBdd *wb, void *bdds) {
+    for (int i = 0; i < WORD_BATCH_SIZE; ++i)
+        derefCleanup(wb, (DdNode**)bdds + i);
+}
+
+
+/* getWordScore(wb, bddWord, score)
+ *
+ * An add giving score for the word in bddWord and -infinity for all else.
+ */
+static DdNode *getWordScore(WordsBdd *wb, DdNode *bddWord, double score) {
+    DdManager *manager = wb->manager;
+
+    DdNode *addWord = Cudd_BddToAdd(manager, bddWord);
+    checkedRef(wb, addWord);
+    pushRef(wb, &addWord);
+    DdNode *addScore = Cudd_addConst(manager, score);
+    checkedRef(wb, addScore);
+    pushRef(wb, &addScore);
+
+    DdNode *wordScore = Cudd_addIte(manager, 
+                                    addWord, 
+                                    addScore, 
+                                    Cudd_ReadMinusInfinity(manager));
+    checkedRef(wb, wordScore);
+    popCleanups(wb, 2);
+    Cudd_RecursiveDeref(manager, addWord);
+    Cudd_RecursiveDeref(manager, addScore);
+
+    return wordScore;
+}
+
+
+/* getDefaultScores(wb, dict)
+ *
+ * Scores every word in dict 0, for when no scores were given.
+ */
+static DdNode *getDefaultScores(WordsBdd *wb, DdNode *dict) {
+    DdManager *manager = wb->manager;
+
+    DdNode *zero = Cudd_addConst(manager, 0.0);
+    checkedRef(wb, zero);
+    pushRef(wb, &zero);
+    DdNode *scores = restrictScores(wb, zero, dict);
+    popCleanups(wb, 1);
+    Cudd_RecursiveDeref(manager, zero);
+    return scores;
+}
+
+
+static DdNode *loadScores(WordsBdd *wb, char *scoresInFile) {
+    DdManager *manager = wb->manager;
+
+    FILE *f = fopen(scoresInFile, "r");
+    if (!f)
+        fail(wb, WB_ERROR, "Error opening %s for reading.", scoresInFile);
+
+    DdNode *scores = Dddmp_cuddAddLoad(manager, 
+                                       DDDMP_VAR_MATCHIDS, 
+                                       0x00, 
+                                       0x00, 
+                                       0x00, 
+                                       DDDMP_MODE_TEXT, 
+                                       scoresInFile, 
+                                       f);
+
+    fclose(f);
+
+    if (scores == 0x00)
+        fail(wb, WB_ERROR, "Could not read scores from %s.", scoresInFile);
+
+    return scores;
+}
+
+static void writeScores(WordsBdd *wb, DdNode *scores, char *scoresOutFile) {
+    DdManager *manager = wb->manager;
+
+    FILE *f = fopen(scoresOutFile, "w");
+    if (!f)
+        fail(wb, WB_ERROR, "Error opening %s for writing.", scoresOutFile);
+
+    // dddmp only supports text mode for adds
+    Dddmp_cuddAddStore(manager, 
+                       scoresOutFile, 
+                       scores, 
+                       0x00, 
+                       0x00, 
+                       DDDMP_MODE_TEXT, 
+                       DDDMP_VARIDS, 
+                       scoresOutFile, 
+                       f);
+
+    fclose(f);
+}
+
+
+static void writeSummary(WordsBdd *wb, DdNode *dict) {
+    DdManager *manager = wb->manager;
+
+    long unsigned int numNodes = Cudd_ReadNodeCount(manager);
+    int numVars = Cudd_ReadSize(manager);
+    
+    // includes null termination
+    long long totalBytes = wb->totalChars + wb->totalWords; 
+    long long totalBits = 8*totalBytes;
+    double compression = (double)numNodes / (double)totalBits;
+
+    logMsg(wb, "%lld words read.\n", wb->totalWords);
+    logMsg(wb, "%lld characters read.\n", wb->totalChars);
+    logMsg(wb, "%lld total bits.\n", totalBits);
+    logMsg(wb, "\n");
+    logMsg(wb, "BDD has %lu nodes.\n", numNodes);
+    logMsg(wb, "BDD has %d variables.\n", numVars);
+    logMsg(wb, "\n");
+    logMsg(wb, "total bits / num nodes =  %f.\n", compression);
+}
+
+
+static DdNode *matchPattern(WordsBdd *wb, DdNode *dict, char *pattern) {
+    DdManager *manager = wb->manager;
+
+    DdNode *bddPat = getWordWildcards(wb, pattern);
+    pushRef(wb, &bddPat);
+
+    DdNode *newDict = Cudd_bddAnd(manager, dict, bddPat);
+    checkedRef(wb, newDict);
+    popCleanups(wb, 1);
+    Cudd_RecursiveDeref(manager, bddPat);
+
+    return newDict;
+}
+
+/* countWords(wb, bdd, len)
+ *
+ * The number of words in bdd, a set of words of len chars such as a match.
+ * These only depend on the vars of the word and its 0x00 ending, so only
+ * those are counted over (cudd can't count over all vars of a big manager).
+ */
+static double countWords(WordsBdd *wb, DdNode *bdd, int len) {
+    return Cudd_CountMinterm(wb->manager, bdd, 8*(len + 1));
+}
+
+
+/* matchFuzzy(wb, dict, word)
+ *
+ * Returns the bdd of all words in dict within edit distance one of word.  The
+ * whole neighbourhood is built symbolically first, so the dictionary is only
+ * touched by a single conjunction.
+ */
+static DdNode *matchFuzzy(WordsBdd *wb, DdNode *dict, char *word) {
+    DdManager *manager = wb->manager;
+
+    if (strlen(word) + 2 > MAX_WORD_SIZE) {
+        fail(wb, 
+             WB_ERROR,
+             "Fuzzy word %s too long (must be under %d chars).",
+             word,
+             MAX_WORD_SIZE - 1);
+    }
+
+    DdNode *bddHood = getFuzzyNeighbourhood(wb, word);
+    pushRef(wb, &bddHood);
+
+    DdNode *newDict = Cudd_bddAnd(manager, dict, bddHood);
+    checkedRef(wb, newDict);
+    popCleanups(wb, 1);
+    Cudd_RecursiveDeref(manager, bddHood);
+
+    return newDict;
+}
+
+/* getFuzzyNeighbourhood(wb, word)
+ *
+ * The union of a wildcard pattern for each kind of edit:
+ *
+ *   substitution : word with position i replaced by *   (length n)
+ *   insertion    : word with * inserted before i        (length n + 1)
+ *   deletion     : word with position i removed         (length n - 1)
+ *
+ * Substitution patterns also cover word itself.
+ */
+static DdNode *getFuzzyNeighbourhood(WordsBdd *wb, char *word) {
+    DdManager *manager = wb->manager;
+
+    DdNode *bddHood = Cudd_ReadLogicZero(manager);
+    Cudd_Ref(bddHood);
+    // orPattern only releases bddHood once it has the new one
+    pushRef(wb, &bddHood);
+
+    char buf[MAX_WORD_SIZE + 1];
+    int size = strlen(word);
+
+    for (int i = 0; i < size; ++i) {
+        strcpy(buf, word);
+        buf[i] = ANY_CHAR;
+        bddHood = orPattern(wb, bddHood, buf);
+    }
+
+    for (int i = 0; i <= size; ++i) {
+        strncpy(buf, word, i);
+        buf[i] = ANY_CHAR;
+        strcpy(buf + i + 1, word + i);
+        bddHood = orPattern(wb, bddHood, buf);
+    }
+
+    // deleting from a one letter word would give the empty word
+    for (int i = 0; i < size && size > 1; ++i) {
+        strncpy(buf, word, i);
+        strcpy(buf + i, word + i + 1);
+        bddHood = orPattern(wb, bddHood, buf);
+    }
+
+    popCleanups(wb, 1);
+    return bddHood;
+}
+
+/* orPattern(wb, bdd, pattern)
+ *
+ * Adds pattern to bdd, consuming the reference to bdd.
+ */
+static DdNode *orPattern(WordsBdd *wb, DdNode *bdd, char *pattern) {
+    DdManager *manager = wb->manager;
+
+    DdNode *bddPat = getWordWildcards(wb, pattern);
+    pushRef(wb, &bddPat);
+
+    DdNode *tmp = Cudd_bddOr(manager, bdd, bddPat);
+    checkedRef(wb, tmp);
+    popCleanups(wb, 1);
+    Cudd_RecursiveDeref(manager, bdd);
+    Cudd_RecursiveDeref(manager, bddPat);
+
+    return tmp;
+}
+
+
+
+/* enumerateWords(wb, dict, callback, data)
+ *
+ * Calls callback with each word in dict.  Returns non-zero if the callback
+ * stopped the enumeration.
+ */
+static int enumerateWords(WordsBdd *wb, 
+                          DdNode *dict, 
+                          WordCallback callback, 
+                          void *data) {
+    DdManager *manager = wb->manager;
+
+    DdGen *gen;
+    int *cube;
+    CUDD_VALUE_TYPE val;
+    char buf[MAX_WORD_SIZE];
+    
+    int nvars = Cudd_ReadSize(manager);
+
+    Cudd_ForeachCube(manager, dict, gen, cube, val) {
+        if (instantiateCube(cube, buf, 0, nvars, callback, data)) {
+            Cudd_GenFree(gen);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void enumerateMatches(WordsBdd *wb, 
+                             DdNode *match, 
+                             int topK,
+                             WordCallback callback, 
+                             void *data) {
+    if (topK > 0)
+        enumerateTopWords(wb, match, getScores(wb), topK, callback, data);
+    else
+        enumerateWords(wb, match, callback, data);
+}
+
+/* enumerateTopWords(wb, match, scores, k, callback, data)
+ *
+ * Calls callback with the k highest scoring words in match, best first.
+ * Rather than enumerating match, repeatedly takes the set of words with the
+ * max score and picks words from it until it is empty, then removes it from
+ * the scores.
+ */
+static void enumerateTopWords(WordsBdd *wb, 
+                              DdNode *match, 
+                              DdNode *scores, 
+                              int k,
+                              WordCallback callback, 
+                              void *data) {
+    DdManager *manager = wb->manager;
+
+    char *cube = (char*)malloc(Cudd_ReadSize(manager));
+    pushCleanup(wb, freeCleanup, cube);
+    char buf[MAX_WORD_SIZE];
+    int found = 0;
+    double max;
+
+    DdNode *matchScores = restrictScores(wb, scores, match);
+    pushRef(wb, &matchScores);
+    DdNode *level = 0x00;
+    DdNode *remaining = 0x00;
+    pushRef(wb, &level);
+    pushRef(wb, &remaining);
+
+    while (found < k && (level = getMaxLevel(wb, matchScores, &max))) {
+        remaining = level;
+        Cudd_Ref(remaining);
+
+        while (found < k && !bddIsEmpty(wb, remaining)) {
+            if (!Cudd_bddPickOneCube(manager, remaining, cube))
+                resourceLimit(wb);
+            decodeWordCube(cube, buf);
+            found++;
+            // stopping early is the same as having found all k
+            if (callback(data, buf, max))
+                found = k;
+
+            DdNode *bddWord = getWord(wb, buf);
+            DdNode *tmp = Cudd_bddAnd(manager, remaining, Cudd_Not(bddWord));
+            Cudd_RecursiveDeref(manager, bddWord);
+            checkedRef(wb, tmp);
+            Cudd_RecursiveDeref(manager, remaining);
+            remaining = tmp;
+        }
+
+        Cudd_RecursiveDeref(manager, remaining);
+        remaining = 0x00;
+
+        DdNode *tmp = removeLevel(wb, matchScores, level);
+        Cudd_RecursiveDeref(manager, matchScores);
+        Cudd_RecursiveDeref(manager, level);
+        matchScores = tmp;
+        level = 0x00;
+    }
+
+    popCleanups(wb, 4);
+    Cudd_RecursiveDeref(manager, matchScores);
+    free(cube);
+}
+
+/* restrictScores(wb, scores, bdd)
+ *
+ * Returns scores where bdd holds, -infinity elsewhere.
+ */
+static DdNode *restrictScores(WordsBdd *wb, DdNode *scores, DdNode *bdd) {
+    DdManager *manager = wb->manager;
+
+    DdNode *add = Cudd_BddToAdd(manager, bdd);
+    checkedRef(wb, add);
+    pushRef(wb, &add);
+
+    DdNode *restricted = Cudd_addIte(manager, 
+                                     add, 
+                                     scores, 
+                                     Cudd_ReadMinusInfinity(manager));
+    checkedRef(wb, restricted);
+    popCleanups(wb, 1);
+    Cudd_RecursiveDeref(manager, add);
+
+    return restricted;
+}
+
+/* getMaxLevel(wb, scores, max)
+ *
+ * Returns the bdd of all paths of scores with the max value (written to max),
+ * or null if all paths are -infinity.
+ */
+static DdNode *getMaxLevel(WordsBdd *wb, DdNode *scores, double *max) {
+    DdManager *manager = wb->manager;
+
+    DdNode *maxNode = Cudd_addFindMax(manager, scores);
+    if (maxNode == Cudd_ReadMinusInfinity(manager))
+        return 0x00;
+
+    *max = Cudd_V(maxNode);
+    DdNode *level = Cudd_addBddInterval(manager, scores, *max, *max);
+    checkedRef(wb, level);
+
+    return level;
+}
+
+/* removeLevel(wb, scores, level)
+ *
+ * Returns scores with all paths in level set to -infinity.
+ */
+static DdNode *removeLevel(WordsBdd *wb, DdNode *scores, DdNode *level) {
+    DdManager *manager = wb->manager;
+
+    DdNode *add = Cudd_BddToAdd(manager, level);
+    checkedRef(wb, add);
+    pushRef(wb, &add);
+
+    DdNode *removed = Cudd_addIte(manager, 
+                                  add, 
+                                  Cudd_ReadMinusInfinity(manager), 
+                                  scores);
+    checkedRef(wb, removed);
+    popCleanups(wb, 1);
+    Cudd_RecursiveDeref(manager, add);
+
+    return removed;
+}
+
+/* decodeWordCube(cube, buf)
+ *
+ * Reads the word in a cube from Cudd_bddPickOneCube into buf, taking don't
+ * cares as 0.
+ */
+static void decodeWordCube(char *cube, char *buf) {
+    int pos = 0;
+    do {
+        buf[pos] = 0x00;
+        for (int bit = 0; bit < 8; ++bit)
+            buf[pos] = setBit(buf[pos], bit, cube[8*pos + bit] == 1);
+    } while (buf[pos++] != 0x00 && pos < MAX_WORD_SIZE);
+    buf[MAX_WORD_SIZE - 1] = 0x00;
+}
+
+/* instantiateCube(cube, buf, i , size, callback, data)
+ *
+ * Given a cube of length given by size, instantiate all cube values of 2 to
+ * first 0 and then 1, passing the results to callback.  i is the index we've
+ * recursed down to, buf is the buffer to write the words to.  Returns
+ * non-zero if the callback asked to stop.
+ */
+static int instantiateCube(int *cube, 
+                           char *buf, 
+                           int i, 
+                           int size, 
+                           WordCallback callback, 
+                           void *data) {
+    int stop = 0;
+    if (i == size) {
+        stop = callback(data, buf, 0.0);
+    } else {
+        if (cube[i] != 2) {
+            int bit = i%8;
+            int cpos = i / 8;
+            buf[cpos] = setBit(buf[cpos], bit, cube[i]);
+            // if we just added a null byte, we're done
+            if (bit == 7 && buf[cpos] == 0x00) 
+                stop = instantiateCube(cube, buf, size, size, callback, data);
+            else 
+                stop = instantiateCube(cube, buf, i+1, size, callback, data);
+        } else {
+            cube[i] = 0;
+            stop = instantiateCube(cube, buf, i, size, callback, data);
+            cube[i] = 1;
+            if (!stop)
+                stop = instantiateCube(cube, buf, i, size, callback, data);
+            cube[i] = 2;
+        }
+    }
+    return stop;
+}
+
+
+
+static int setBit(int orig, int bit, int val) {
+    return (orig & ~(1<<bit)) | val<<bit;
+}
+
+static int getBit(int i, int bit) {
+    return (i & (1<<bit)) ? 1 : 0;
+}
+
+
+/* loadBdd(wb, bddInFile)
+ *
+ * Reads a dictionary written by writeBddDict, failing if it is not one, was
+ * built with a different encoding, or is truncated or corrupt.  Plain dddmp
+ * files from before the container format are still read.
+ */
+static DdNode *loadBdd(WordsBdd *wb, char *bddInFile) {
+    DdManager *manager = wb->manager;
+
+    long fileSize;
+    unsigned char *file = readFile(wb, bddInFile, &fileSize);
+    unsigned char *raw = file;
+    long rawSize = fileSize;
+
+    if (fileSize >= DICT_HEADER_SIZE && 
+        memcmp(file, DICT_MAGIC, DICT_MAGIC_SIZE) == 0) {
+        raw = readDictContainer(wb, bddInFile, file, fileSize, &rawSize);
+    } else if (fileSize < DDDMP_MAGIC_SIZE || 
+               memcmp(file, DDDMP_MAGIC, DDDMP_MAGIC_SIZE) != 0) {
+        free(file);
+        fail(wb, WB_ERROR, "%s is not a dictionary file.", bddInFile);
+    }
+
+    FILE *f = fmemopen(raw, rawSize, "r");
+    DdNode *dict = 0x00;
+    if (f) {
+        dict = Dddmp_cuddBddLoad(manager, 
+                                 DDDMP_VAR_MATCHIDS, 
+                                 0x00, 
+                                 0x00, 
+                                 0x00, 
+                                 DDDMP_MODE_BINARY, 
+                                 bddInFile, 
+                                 f);
+        fclose(f);
+    }
+
+    if (raw != file)
+        free(raw);
+    free(file);
+
+    if (dict == 0x00)
+        fail(wb, WB_ERROR, "Could not read dictionary from %s.", bddInFile);
+
+    return dict;
+}
+
+/* readDictContainer(wb, bddInFile, file, fileSize, rawSize)
+ *
+ * Checks the header and checksum of a container read into file, returning
+ * the malloc'd dddmp data it holds and setting *rawSize to its length.
+ */
+static unsigned char *readDictContainer(WordsBdd *wb,
+                                        char *bddInFile,
+                                        unsigned char *file,
+                                        long fileSize,
+                                        long *rawSize) {
+    unsigned long version = getU32(file + 4);
+    unsigned long flags = getU32(file + 8);
+    unsigned long charBits = getU32(file + 12);
+    unsigned long maxWordSize = getU32(file + 16);
+    unsigned long stored = getU32(file + 24);
+    unsigned long checksum = getU32(file + 28);
+    *rawSize = getU32(file + 20);
+
+    char *error = 0x00;
+    if (version != DICT_VERSION)
+        error = "was written by an unsupported version";
+    else if (charBits != 8 || maxWordSize != MAX_WORD_SIZE)
+        error = "uses a different word encoding";
+    else if (stored != (unsigned long)(fileSize - DICT_HEADER_SIZE))
+        error = "is truncated";
+
+    unsigned char *raw = 0x00;
+    if (!error) {
+        raw = (unsigned char*)malloc(*rawSize > 0 ? *rawSize : 1);
+        if (raw == 0x00) {
+            error = "is too big to load";
+        } else if (flags & DICT_COMPRESSED) {
+            long len = lzDecompress(file + DICT_HEADER_SIZE, 
+                                    stored, 
+                                    raw, 
+                                    *rawSize);
+            if (len != *rawSize)
+                error = "is corrupt";
+        } else if (stored != (unsigned long)*rawSize) {
+            error = "is corrupt";
+        } else {
+            memcpy(raw, file + DICT_HEADER_SIZE, stored);
+        }
+    }
+
+    if (!error && getChecksum(raw, *rawSize) != checksum)
+        error = "is corrupt (checksum mismatch)";
+
+    if (error) {
+        free(raw);
+        free(file);
+        fail(wb, WB_ERROR, "Dictionary %s %s.", bddInFile, error);
+    }
+
+    return raw;
+}
+
+/* writeBddDict(wb, dict, bddOutFile)
+ *
+ * Writes dict as binary dddmp wrapped in a container:
+ *
+ *   magic "WBDD", then 32 bit little endian fields
+ *   version, flags, bits per char, max word size, 
+ *   dddmp size, stored size, crc-32 of the dddmp data
+ *
+ * followed by the dddmp data, lz compressed if wb->compress and it helps.
+ */
+static void writeBddDict(WordsBdd *wb, DdNode *dict, char *bddOutFile) {
+    DdManager *manager = wb->manager;
+
+    char *raw = 0x00;
+    size_t rawSize = 0;
+    FILE *mem = open_memstream(&raw, &rawSize);
+    if (!mem)
+        fail(wb, WB_ERROR, "Could not buffer %s.", bddOutFile);
+
+    int ok = Dddmp_cuddBddStore(manager, 
+                                bddOutFile, 
+                                dict, 
+                                0x00, 
+                                0x00, 
+                                DDDMP_MODE_BINARY, 
+                                DDDMP_VARIDS, 
+                                bddOutFile, 
+                                mem);
+    fclose(mem);
+
+    if (ok != DDDMP_SUCCESS) {
+        free(raw);
+        fail(wb, WB_ERROR, "Could not write dictionary to %s.", bddOutFile);
+    }
+    // the header sizes are 32 bits, and only smaller compressed data is kept
+    if (rawSize > DICT_MAX_SIZE) {
+        free(raw);
+        fail(wb, 
+             WB_ERROR, 
+             "Dictionary too big for %s (over %lu bytes).", 
+             bddOutFile, 
+             DICT_MAX_SIZE);
+    }
+
+    unsigned char *stored = (unsigned char*)raw;
+    long storedSize = rawSize;
+    unsigned long flags = 0;
+
+    if (wb->compress) {
+        unsigned char *packed = (unsigned char*)malloc(getLzBound(rawSize));
+        long packedSize = packed 
+                        ? lzCompress((unsigned char*)raw, rawSize, packed)
+                        : 0;
+        // lzCompress gives 0 if it could not allocate its table
+        if (packed && packedSize > 0 && packedSize < (long)rawSize) {
+            stored = packed;
+            storedSize = packedSize;
+            flags |= DICT_COMPRESSED;
+        } else {
+            free(packed);
+        }
+    }
+
+    unsigned char header[DICT_HEADER_SIZE];
+    memcpy(header, DICT_MAGIC, DICT_MAGIC_SIZE);
+    putU32(header + 4, DICT_VERSION);
+    putU32(header + 8, flags);
+    putU32(header + 12, 8);
+    putU32(header + 16, MAX_WORD_SIZE);
+    putU32(header + 20, rawSize);
+    putU32(header + 24, storedSize);
+    putU32(header + 28, getChecksum((unsigned char*)raw, rawSize));
+
+    FILE *f = fopen(bddOutFile, "wb");
+    ok = f &&
+         fwrite(header, 1, DICT_HEADER_SIZE, f) == DICT_HEADER_SIZE &&
+         fwrite(stored, 1, storedSize, f) == (size_t)storedSize;
+    if (f && fclose(f) != 0)
+        ok = 0;
+
+    if (stored != (unsigned char*)raw)
+        free(stored);
+    free(raw);
+
+    if (!ok)
+        fail(wb, WB_ERROR, "Error writing %s.", bddOutFile);
+}
+
+/* readFile(wb, path, size)
+ *
+ * Returns the malloc'd contents of path, setting *size to its length.
+ */
+static unsigned char *readFile(WordsBdd *wb, char *path, long *size) {
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        fail(wb, WB_ERROR, "Error opening %s for reading.", path);
+
+    long capacity = DICT_READ_CHUNK;
+    unsigned char *buf = (unsigned char*)malloc(capacity);
+    *size = 0;
+
+    while (buf) {
+        *size += fread(buf + *size, 1, capacity - *size, f);
+        if (*size < capacity)
+            break;
+        capacity *= 2;
+        unsigned char *bigger = (unsigned char*)realloc(buf, capacity);
+        if (bigger == 0x00)
+            free(buf);
+        buf = bigger;
+    }
+
+    int error = ferror(f);
+    fclose(f);
+
+    if (buf == 0x00 || error) {
+        free(buf);
+        fail(wb, WB_ERROR, "Error reading %s.", path);
+    }
+
+    return buf;
+}
+
+static void putU32(unsigned char *p, unsigned long v) {
+    for (int i = 0; i < 4; ++i)
+        p[i] = (v >> (8*i)) & 0xff;
+}
+
+static unsigned long getU32(unsigned char *p) {
+    unsigned long v = 0;
+    for (int i = 0; i < 4; ++i)
+        v |= (unsigned long)p[i] << (8*i);
+    return v;
+}
+
+/* getChecksum(buf, size)
+ *
+ * The crc-32 (as in zlib) of buf.
+ */
+static unsigned long getChecksum(unsigned char *buf, long size) {
+    static unsigned long table[256];
+    static int tableMade = 0;
+
+    if (!tableMade) {
+        for (unsigned long n = 0; n < 256; ++n) {
+            unsigned long c = n;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xedb88320UL ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        tableMade = 1;
+    }
+
+    unsigned long crc = 0xffffffffUL;
+    for (long i = 0; i < size; ++i)
+        crc = table[(crc ^ buf[i]) & 0xff] ^ (crc >> 8);
+    return crc ^ 0xffffffffUL;
+}
+
+static long getLzBound(long size) {
+    return size + size / 255 + 16;
+}
+
+/* lzCompress(src, size, dst)
+ *
+ * Compresses src into dst (of at least getLzBound(size) bytes) as lz4 style
+ * sequences, returning the compressed size.  Each sequence is
+ *
+ *   token          : literal count (high nibble), match length - LZ_MIN_MATCH
+ *                    (low nibble), a nibble of 15 continuing in the bytes
+ *                    after (as 255s then a final byte below 255)
+ *   literals
+ *   offset         : 2 bytes little endian, back from the end of the literals
+ *
+ * and the last sequence has only literals.
+ */
+static long lzCompress(unsigned char *src, long size, unsigned char *dst) {
+    // positions + 1 of the last occurrence of each hashed 4 bytes
+    long *table = (long*)calloc(LZ_HASH_SIZE, sizeof(long));
+    if (table == 0x00)
+        return 0;
+
+    long ip = 0;
+    long anchor = 0;
+    long op = 0;
+
+    while (ip + LZ_MIN_MATCH <= size) {
+        unsigned long h = (getU32(src + ip) * 2654435761UL) & 0xffffffffUL;
+        h >>= 32 - LZ_HASH_BITS;
+        long ref = table[h] - 1;
+        table[h] = ip + 1;
+
+        if (ref < 0 || 
+            ip - ref > LZ_MAX_OFFSET || 
+            memcmp(src + ref, src + ip, LZ_MIN_MATCH) != 0) {
+            ip++;
+            continue;
+        }
+
+        long len = LZ_MIN_MATCH;
+        while (ip + len < size && src[ref + len] == src[ip + len])
+            len++;
+
+        op = lzPutSequence(dst, op, src + anchor, ip - anchor, len);
+        dst[op++] = (ip - ref) & 0xff;
+        dst[op++] = (ip - ref) >> 8;
+        op = lzPutLength(dst, op, len - LZ_MIN_MATCH);
+
+        ip += len;
+        anchor = ip;
+    }
+
+    op = lzPutSequence(dst, op, src + anchor, size - anchor, LZ_MIN_MATCH);
+
+    free(table);
+    return op;
+}
+
+/* lzPutSequence(dst, op, literals, numLiterals, matchLen)
+ *
+ * Writes a sequence's token and literals at dst + op, returning the new op.
+ */
+static long lzPutSequence(unsigned char *dst, 
+                          long op, 
+                          unsigned char *literals, 
+                          long numLiterals,
+                          long matchLen) {
+    long litNibble = numLiterals < 15 ? numLiterals : 15;
+    long matchNibble = matchLen - LZ_MIN_MATCH < 15 
+                     ? matchLen - LZ_MIN_MATCH 
+                     : 15;
+    dst[op++] = (litNibble << 4) | matchNibble;
+    op = lzPutLength(dst, op, numLiterals);
+    memcpy(dst + op, literals, numLiterals);
+    return op + numLiterals;
+}
+
+/* lzPutLength(dst, op, len)
+ *
+ * Writes the continuation bytes of a length whose nibble was 15.
+ */
+static long lzPutLength(unsigned char *dst, long op, long len) {
+    if (len < 15)
+        return op;
+    for (len -= 15; len >= 255; len -= 255)
+        dst[op++] = 255;
+    dst[op++] = len;
+    return op;
+}
+
+/* lzDecompress(src, size, dst, capacity)
+ *
+ * Undoes lzCompress, returning the decompressed size, or -1 if src is
+ * malformed or would not fit in capacity bytes.
+ */
+static long lzDecompress(unsigned char *src, 
+                         long size, 
+                         unsigned char *dst, 
+                         long capacity) {
+    long ip = 0;
+    long op = 0;
+
+    while (ip < size) {
+        int token = src[ip++];
+
+        long numLiterals = lzGetLength(src, size, &ip, token >> 4);
+        if (numLiterals < 0 || 
+            numLiterals > size - ip || 
+            numLiterals > capacity - op)
+            return -1;
+        memcpy(dst + op, src + ip, numLiterals);
+        ip += numLiterals;
+        op += numLiterals;
+
+        // the last sequence has no match
+        if (ip == size)
+            break;
+
+        if (size - ip < 2)
+            return -1;
+        long offset = src[ip] | (src[ip + 1] << 8);
+        ip += 2;
+
+        long len = lzGetLength(src, size, &ip, token & 15);
+        if (len < 0 || offset == 0 || offset > op)
+            return -1;
+        len += LZ_MIN_MATCH;
+        if (len > capacity - op)
+            return -1;
+
+        // byte by byte, as the match may overlap what it is copying
+        for (long i = 0; i < len; ++i, ++op)
+            dst[op] = dst[op - offset];
+    }
+
+    return op;
+}
+
+static long lzGetLength(unsigned char *src, long size, long *ip, int nibble) {
+    long len = nibble;
+    if (nibble < 15)
+        return len;
+
+    int b;
+    do {
+        if (*ip >= size)
+            return -1;
+        b = src[(*ip)++];
+        len += b;
+    } while (b == 255);
+
+    return len;
+}
+
+
+static int bddIsEmpty(WordsBdd *wb, DdNode *bdd) {
+    DdManager *manager = wb->manager;
+
+    DdNode *zero = Cudd_ReadLogicZero(manager);
+    return bdd == zero;
+}
+
+
+static Crossword readCrossword(WordsBdd *wb, char *crosswordFile, int rawFormat) {
+    if (rawFormat)
+        return readCrosswordRaw(wb, crosswordFile);
+    else
+        return readCrosswordDiagram(wb, crosswordFile);
+}
+
+
+static Crossword readCrosswordRaw(WordsBdd *wb, char *crosswordFile) {
+    Crossword cw;
+
+    FILE *f = fopen(crosswordFile, "r");
+    if (!f)
+        fail(wb, WB_ERROR, "Error opening %s for read.", crosswordFile);
+
+    // count lines
+    char dir;
+    int x;
+    int y;
+    char pat[MAX_WORD_SIZE + 1]; // RAW_FORMAT reads up to MAX_WORD_SIZE chars
+    cw.size = 0;
+    while (fscanf(f, RAW_FORMAT, &dir, &x, &y, pat) == 4) 
+        cw.size++;
+
+    cw.clues = (Clue*)malloc(cw.size * sizeof(Clue));
+
+    // read crossword
+    rewind(f);
+    int i = 0;
+    while (fscanf(f, RAW_FORMAT, &dir, &x, &y, pat) == 4) {
+        // grids are indexed by clue squares, so they must all be in it
+        int len = strlen(pat);
+        int end = (dir == DIR_ACROSS) ? x + len : y + len;
+        if (x < 0 || 
+            y < 0 || 
+            x >= MAX_WORD_SIZE || 
+            y >= MAX_WORD_SIZE || 
+            len >= MAX_WORD_SIZE || 
+            end > MAX_WORD_SIZE) {
+            fclose(f);
+            free(cw.clues);
+            fail(wb,
+                 WB_ERROR,
+                 "Clue %c %d %d %s in %s does not fit a %dx%d grid.",
+                 dir,
+                 x,
+                 y,
+                 pat,
+                 crosswordFile,
+                 MAX_WORD_SIZE,
+                 MAX_WORD_SIZE);
+        }
+        cw.clues[i].across = (dir == DIR_ACROSS);
+        cw.clues[i].x = x;
+        cw.clues[i].y = y;
+        strcpy(cw.clues[i].pattern, pat);
+        i++;
+    }
+
+    fclose(f);
+
+    logMsg(wb, "Crossword read:\n\n");
+    printCrossword(wb, &cw);
+
+    return cw;
+}
+
+
+static Crossword readCrosswordDiagram(WordsBdd *wb, char *crosswordFile) {
+    Crossword cw;
+
+    FILE *f = fopen(crosswordFile, "r");
+    if (!f)
+        fail(wb, WB_ERROR, "Error opening %s for read.", crosswordFile);
+
+    // read crossword to grid and print for user
+    logMsg(wb, "Crossword read:\n\n");
+    char grid[MAX_WORD_SIZE][MAX_WORD_SIZE] = { { 0 } };
+    char c;
+    int x = 0;
+    int y = 0;
+    while ((c = tolower(getc(f))) != EOF) {
+        logMsg(wb, "%c", c);
+        if (x >= MAX_WORD_SIZE || y >= MAX_WORD_SIZE) {
+            fclose(f);
+            fail(wb,
+                 WB_ERROR,
+                 "Crossword in %s too big (must be within %dx%d).",
+                 crosswordFile,
+                 MAX_WORD_SIZE,
+                 MAX_WORD_SIZE);
+        }
+        if (c != '\n') {
+            grid[x++][y] = c;
+        } else {
+            x = 0;
+            y++;
+        }
+    }
+
+    fclose(f);
+
+    cw.size = 0;
+    // count clues 
+    for (y = 0; y < MAX_WORD_SIZE; ++y) {
+        for (x = 0; x < MAX_WORD_SIZE; ++x) {
+            if (acrossStart(&grid, x, y))
+                cw.size++;
+            if (downStart(&grid, x, y))
+                cw.size++;
+        }
+    }
+
+    // read crossword
+    cw.clues = (Clue*)malloc(cw.size * sizeof(Clue));
+
+    int i = 0;
+    for (y = 0; y < MAX_WORD_SIZE; ++y) {
+        for (x = 0; x < MAX_WORD_SIZE; ++x) {
+            if (acrossStart(&grid, x, y)) {
+                cw.clues[i].across = 1;
+                cw.clues[i].x = x;
+                cw.clues[i].y = y;
+                getAcrossPattern(&grid, x, y, cw.clues[i].pattern);
+                i++;
+            }
+            if (downStart(&grid, x, y)) {
+                cw.clues[i].across = 0;
+                cw.clues[i].x = x;
+                cw.clues[i].y = y;
+                getDownPattern(&grid, x, y, cw.clues[i].pattern);
+                i++;
+            }
+        }
+    }
+
+    return cw;
+}
+
+
+static void printCrossword(WordsBdd *wb, Crossword *cw) {
+    for (int i = 0; i < cw->size; ++i) {
+        logMsg(wb,
+               "%c %d %d %s\n", 
+               (cw->clues[i].across ? DIR_ACROSS : DIR_DOWN),
+               cw->clues[i].x,
+               cw->clues[i].y,
+               cw->clues[i].pattern);
+    }
+}
+
+
+static DdNode *getClueBdd(WordsBdd *wb, 
+                          DdNode *dict, 
+                          Crossword *cw, 
+                          Clue *clue,
+                          int clueIndex) {
+    DdManager *manager = wb->manager;
+
+    int size = strlen(clue->pattern);
+
+    DdNode *patternBdd = getWordWildcards(wb, clue->pattern);
+    DdNode *clueBdd = Cudd_bddAnd(manager, patternBdd, dict);
+    Cudd_RecursiveDeref(manager, patternBdd);
+    if (clueBdd == 0x00)
+        return 0x00;
+    Cudd_Ref(clueBdd);
+
+    // replace all variables in word with position vars
+    for (int i = 0; i < size; ++i) {
+        for (int b = 0; b < 8; ++b) {
+            DdNode *posVar = getClueBddVar(wb, cw, clue, i, b);
+            DdNode *tmp = Cudd_bddCompose(manager, clueBdd, posVar, 8*i + b);
+            Cudd_RecursiveDeref(manager, clueBdd);
+            if (tmp == 0x00)
+                return 0x00;
+            Cudd_Ref(tmp);
+            clueBdd = tmp;
+        }
+    }
+
+    // replace 0x00 ending with end var for clue
+    for (int b = 0; b < 8; ++b) {
+        DdNode *endVar = getClueBddEndVar(wb, clueIndex, b);
+        DdNode *tmp = Cudd_bddCompose(manager, clueBdd, endVar, 8*size + b);
+        Cudd_RecursiveDeref(manager, clueBdd);
+        if (tmp == 0x00)
+            return 0x00;
+        Cudd_Ref(tmp);
+        clueBdd = tmp;
+    }
+
+    // existentially abstract all other vars in dict
+    for (int i = 8*(size+1); i < 8*MAX_WORD_SIZE; ++i) {
+        DdNode *charVar = Cudd_bddIthVar(manager, i);
+        DdNode *tmp = Cudd_bddExistAbstract(manager, clueBdd, charVar);
+        Cudd_RecursiveDeref(manager, clueBdd);
+        if (tmp == 0x00)
+            return 0x00;
+        Cudd_Ref(tmp);
+        clueBdd = tmp;
+    }
+
+    return clueBdd;
+}
+
+
+static int getCoordBddVarIndex(int x, int y, int bit, Crossword *cw) {
+    return 8*(MAX_WORD_SIZE + cw->size + y * MAX_WORD_SIZE + x) + bit;
+}
+
+static int getClueBddVarIndex(Crossword *cw, 
+                              Clue *clue, 
+                              int pos,
+                              int bit) {
+    int x, y;
+    if (clue->across) {
+        x = clue->x + pos;
+        y = clue->y;
+    } else {
+        x = clue->x;
+        y = clue->y + pos;
+    }
+    return getCoordBddVarIndex(x, y, bit, cw);
+}
+
+
+static DdNode *getClueBddVar(WordsBdd *wb, 
+                             Crossword *cw, 
+                             Clue *clue, 
+                             int pos,
+                             int bit) {
+    DdManager *manager = wb->manager;
+
+    int var = getClueBddVarIndex(cw, clue, pos, bit);
+    return Cudd_bddIthVar(manager, var);
+}
+
+static int getClueBddEndVarIndex(int clueIndex, int bit) {
+    return 8 * (MAX_WORD_SIZE + clueIndex) + bit;
+}
+
+
+static DdNode *getClueBddEndVar(WordsBdd *wb, int clueIndex, int bit) {
+    DdManager *manager = wb->manager;
+
+    return Cudd_bddIthVar(manager, getClueBddEndVarIndex(clueIndex, bit));
+}
+
+
+/* encodeCrossword(wb, dict, cw, order)
+ *
+ * Conjoins the clue bdds of cw, in the order of clue indices given by order
+ * (or clue order if order is null).  Returns null (with nothing left
+ * referenced) if cudd runs out of memory or exceeds its live node limit.
+ */
+static DdNode *encodeCrossword(WordsBdd *wb, 
+                               DdNode *dict, 
+                               Crossword *cw, 
+                               int *order) {
+    DdManager *manager = wb->manager;
+
+    DdNode *cwBdd = Cudd_ReadOne(manager);
+    Cudd_Ref(cwBdd);
+    pushRef(wb, &cwBdd);
+
+    char phaseName[MAX_PHASE_NAME_SIZE];
+
+    for (int j = 0; j < cw->size; ++j) {
+        int i = order ? order[j] : j;
+
+        sprintf(phaseName, "encode clue %d", i);
+        beginPhase(wb, phaseName);
+        DdNode *clueBdd = getClueBdd(wb, 
+                                     dict, 
+                                     cw,
+                                     &cw->clues[i],
+                                     i);
+        endPhase(wb);
+        if (clueBdd == 0x00) {
+            popCleanups(wb, 1);
+            Cudd_RecursiveDeref(manager, cwBdd);
+            return 0x00;
+        }
+
+        beginPhase(wb, "conjunction");
+        DdNode *tmp = Cudd_bddAnd(manager, cwBdd, clueBdd);
+        endPhase(wb);
+        Cudd_RecursiveDeref(manager, cwBdd);
+        Cudd_RecursiveDeref(manager, clueBdd);
+        cwBdd = tmp;
+        if (cwBdd == 0x00) {
+            popCleanups(wb, 1);
+            return 0x00;
+        }
+        Cudd_Ref(cwBdd);
+    }
+
+    popCleanups(wb, 1);
+    return cwBdd;
+}
+
+/* solveCrossword(wb, dict, cw, topK, callback, data)
+ *
+ * Encodes cw and calls callback with its solutions.  If cudd hits its
+ * resource limits, tries again with dynamic reordering and the clues
+ * conjoined in crossing order, then by splitting on the words of the most
+ * constrained clue.  Fails with WB_RESOURCE_LIMIT if all of these fail.
+ * Reordering is turned off again afterwards, as it would only slow down
+ * later queries.
+ */
+static void solveCrossword(WordsBdd *wb, 
+                           DdNode *dict, 
+                           Crossword *cw,
+                           int topK,
+                           SolutionCallback callback,
+                           void *data) {
+    DdManager *manager = wb->manager;
+
+    int *order = getCrossingOrder(cw);
+    pushCleanup(wb, freeCleanup, order);
+
+    DdNode *cwBdd = encodeCrossword(wb, dict, cw, 0x00);
+    int reordering = 0;
+
+    if (cwBdd == 0x00) {
+        logMsg(wb, "\nResource limit reached, retrying with reordering.\n");
+        Cudd_ClearErrorCode(manager);
+        Cudd_AutodynEnable(manager, CUDD_REORDER_SIFT);
+        pushCleanup(wb, disableReorderCleanup, 0x00);
+        reordering = 1;
+        cwBdd = encodeCrossword(wb, dict, cw, order);
+    }
+
+    if (cwBdd == 0x00) {
+        logMsg(wb, "\nResource limit reached, splitting crossword.\n");
+        Cudd_ClearErrorCode(manager);
+        solveCrosswordSplit(wb, dict, cw, order, topK, callback, data);
+    } else {
+        pushRef(wb, &cwBdd);
+        enumerateCrosswordSolutions(wb, cwBdd, cw, topK, callback, data);
+        popCleanups(wb, 1);
+        Cudd_RecursiveDeref(manager, cwBdd);
+    }
+
+    popCleanups(wb, 1 + reordering);
+    if (reordering)
+        disableReorderCleanup(wb, 0x00);
+    free(order);
+}
+
+static void disableReorderCleanup(WordsBdd *wb, void *unused) {
+    Cudd_AutodynDisable(wb->manager);
+}
+
+/* solveCrosswordSplit(wb, dict, cw, order, topK, callback, data)
+ *
+ * Solves cw once for each word that fits its most constrained clue, passing
+ * solutions on as they are found.  With topK, the best of each part are kept
+ * in a heap instead, and the topK best overall given at the end.  Returns
+ * non-zero if the callback stopped the enumeration.
+ */
+static int solveCrosswordSplit(WordsBdd *wb, 
+                               DdNode *dict, 
+                               Crossword *cw, 
+                               int *order,
+                               int topK,
+                               SolutionCallback callback,
+                               void *data) {
+    DdManager *manager = wb->manager;
+
+    TopSolutions top;
+    top.best = (TopSolution*)malloc(topK * sizeof(TopSolution));
+    top.size = 0;
+    top.k = topK;
+    pushCleanup(wb, freeCleanup, top.best);
+
+    SavedPattern saved;
+    saved.clue = &cw->clues[getMostConstrainedClue(wb, dict, cw)];
+    strcpy(saved.pattern, saved.clue->pattern);
+    Clue *clue = saved.clue;
+
+    DdNode *words = matchPattern(wb, dict, saved.pattern);
+    pushRef(wb, &words);
+    // the clue holds each split word while it is solved
+    pushCleanup(wb, restorePatternCleanup, &saved);
+    DdNode *cwBdd = 0x00;
+    pushRef(wb, &cwBdd);
+    int stop = 0;
+
+    while (!stop && !bddIsEmpty(wb, words)) {
+        char *cube = (char*)malloc(Cudd_ReadSize(manager));
+        if (!Cudd_bddPickOneCube(manager, words, cube)) {
+            free(cube);
+            resourceLimit(wb);
+        }
+        decodeWordCube(cube, clue->pattern);
+        free(cube);
+
+        DdNode *bddWord = getWord(wb, clue->pattern);
+        DdNode *tmp = Cudd_bddAnd(manager, words, Cudd_Not(bddWord));
+        Cudd_RecursiveDeref(manager, bddWord);
+        checkedRef(wb, tmp);
+        Cudd_RecursiveDeref(manager, words);
+        words = tmp;
+
+        cwBdd = encodeCrossword(wb, dict, cw, order);
+        if (cwBdd == 0x00)
+            resourceLimit(wb);
+
+        if (topK > 0)
+            enumerateCrosswordSolutions(wb, 
+                                        cwBdd, 
+                                        cw, 
+                                        topK, 
+                                        addTopSolution, 
+                                        &top);
+        else
+            stop = enumerateCrosswordSolutions(wb, 
+                                               cwBdd, 
+                                               cw, 
+                                               0, 
+                                               callback, 
+                                               data);
+        Cudd_RecursiveDeref(manager, cwBdd);
+        cwBdd = 0x00;
+    }
+
+    popCleanups(wb, 4);
+    Cudd_RecursiveDeref(manager, words);
+    restorePatternCleanup(wb, &saved);
+
+    qsort(top.best, top.size, sizeof(TopSolution), compareTopSolutions);
+    for (int i = 0; i < top.size && !stop; ++i)
+        stop = callback(data, &top.best[i].grid, top.best[i].score);
+    free(top.best);
+
+    return stop;
+}
+
+/* addTopSolution(top, grid, score)
+ *
+ * A SolutionCallback keeping the top->k best solutions in a heap with the
+ * worst at top->best[0].  Solutions come best first within a part, so it
+ * stops the part at the first one not kept.
+ */
+static int addTopSolution(void *top, 
+                          char (*grid)[MAX_WORD_SIZE][MAX_WORD_SIZE], 
+                          double score) {
+    TopSolutions *t = (TopSolutions*)top;
+    TopSolution *heap = t->best;
+
+    int i;
+    if (t->size < t->k) {
+        // sift up from the end
+        i = t->size++;
+        while (i > 0 && heap[(i - 1)/2].score > score) {
+            heap[i] = heap[(i - 1)/2];
+            i = (i - 1)/2;
+        }
+    } else if (score > heap[0].score) {
+        // sift down from the root, replacing the worst
+        i = 0;
+        for (;;) {
+            int child = 2*i + 1;
+            if (child >= t->size)
+                break;
+            if (child + 1 < t->size && heap[child + 1].score < heap[child].score)
+                child++;
+            if (heap[child].score >= score)
+                break;
+            heap[i] = heap[child];
+            i = child;
+        }
+    } else {
+        return 1;
+    }
+
+    heap[i].score = score;
+    memcpy(heap[i].grid, grid, sizeof(heap[i].grid));
+    return 0;
+}
+
+static int compareTopSolutions(const void *a, const void *b) {
+    double sa = ((TopSolution*)a)->score;
+    double sb = ((TopSolution*)b)->score;
+    return (sa < sb) - (sa > sb);
+}
+
+static void restorePatternCleanup(WordsBdd *wb, void *saved) {
+    SavedPattern *s = (SavedPattern*)saved;
+    strcpy(s->clue->pattern, s->pattern);
+}
+
+static int enumerateCrosswordSolutions(WordsBdd *wb, 
+                                       DdNode *cwBdd, 
+                                       Crossword *cw,
+                                       int topK,
+                                       SolutionCallback callback,
+                                       void *data) {
+    int stop;
+    beginPhase(wb, "enumerate");
+    if (topK > 0)
+        stop = enumerateTopSolutions(wb, 
+                                     cwBdd, 
+                                     getScores(wb), 
+                                     cw, 
+                                     topK, 
+                                     callback, 
+                                     data);
+    else
+        stop = enumerateSolutions(wb, cwBdd, cw, callback, data);
+    endPhase(wb);
+    return stop;
+}
+
+/* getCrossingOrder(cw)
+ *
+ * Returns a malloc'd order of the clue indices of cw where each clue crosses
+ * as many of the clues before it as possible, so the conjunction stays local.
+ */
+static int *getCrossingOrder(Crossword *cw) {
+    int *order = (int*)malloc(cw->size * sizeof(int));
+    int *placed = (int*)calloc(cw->size, sizeof(int));
+
+    for (int j = 0; j < cw->size; ++j) {
+        int best = -1;
+        int bestCrossings = -1;
+        for (int i = 0; i < cw->size; ++i) {
+            if (placed[i])
+                continue;
+            int crossings = 0;
+            for (int k = 0; k < j; ++k)
+                crossings += cluesCross(&cw->clues[i], &cw->clues[order[k]]);
+            if (crossings > bestCrossings) {
+                best = i;
+                bestCrossings = crossings;
+            }
+        }
+        order[j] = best;
+        placed[best] = 1;
+    }
+
+    free(placed);
+    return order;
+}
+
+static int cluesCross(Clue *a, Clue *b) {
+    if (a->across == b->across)
+        return 0;
+
+    Clue *across = a->across ? a : b;
+    Clue *down = a->across ? b : a;
+
+    return down->x >= across->x &&
+           down->x < across->x + (int)strlen(across->pattern) &&
+           across->y >= down->y &&
+           across->y < down->y + (int)strlen(down->pattern);
+}
+
+/* getMostConstrainedClue(wb, dict, cw)
+ *
+ * Returns the index of the clue with fewest (but more than one) matching
+ * words, or 0 if there is none.
+ */
+static int getMostConstrainedClue(WordsBdd *wb, DdNode *dict, Crossword *cw) {
+    DdManager *manager = wb->manager;
+
+    int best = 0;
+    double bestCount = -1;
+
+    for (int i = 0; i < cw->size; ++i) {
+        char *pattern = cw->clues[i].pattern;
+        DdNode *match = matchPattern(wb, dict, pattern);
+        double count = countWords(wb, match, strlen(pattern));
+        Cudd_RecursiveDeref(manager, match);
+        if (count > 1 && (bestCount < 0 || count < bestCount)) {
+            best = i;
+            bestCount = count;
+        }
+    }
+
+    return best;
+}
+
+
+static int enumerateSolutions(WordsBdd *wb, 
+                              DdNode *cwBdd, 
+                              Crossword *cw,
+                              SolutionCallback callback,
+                              void *data) {
+    DdManager *manager = wb->manager;
+
+    DdGen *gen;
+    int *cube;
+    CUDD_VALUE_TYPE val;
+    int stop = 0;
+    
+    int nvars = Cudd_ReadSize(manager);
+    int *mask = getRelevanceMask(cw, nvars);
+
+    Cudd_ForeachCube(manager, cwBdd, gen, cube, val) {
+        stop = instantiateSolutionCube(cube, 
+                                       mask, 
+                                       0, 
+                                       nvars, 
+                                       cw, 
+                                       callback, 
+                                       data);
+        if (stop) {
+            Cudd_GenFree(gen);
+            break;
+        }
+    }
+
+    free(mask);
+    return stop;
+}
+
+/* getClueScores(wb, scores, cw, clue, clueIndex)
+ *
+ * As getClueBdd, but an add giving the score of the word placed in the clue
+ * (-infinity if it is not a matching word).
+ */
+static DdNode *getClueScores(WordsBdd *wb, 
+                             DdNode *scores,
+                             Crossword *cw,
+                             Clue *clue,
+                             int clueIndex) {
+    DdManager *manager = wb->manager;
+
+    int size = strlen(clue->pattern);
+
+    DdNode *patternBdd = getWordWildcards(wb, clue->pattern);
+    pushRef(wb, &patternBdd);
+    DdNode *clueScores = restrictScores(wb, scores, patternBdd);
+    popCleanups(wb, 1);
+    Cudd_RecursiveDeref(manager, patternBdd);
+    pushRef(wb, &clueScores);
+
+    // scores do not depend on vars after the 0x00 ending, so only the word
+    // and ending need replacing
+    for (int i = 0; i <= size; ++i) {
+        for (int b = 0; b < 8; ++b) {
+            int var = (i < size)
+                    ? getClueBddVarIndex(cw, clue, i, b)
+                    : getClueBddEndVarIndex(clueIndex, b);
+            DdNode *posVar = Cudd_addIthVar(manager, var);
+            checkedRef(wb, posVar);
+            DdNode *tmp = Cudd_addCompose(manager, clueScores, posVar, 8*i + b);
+            Cudd_RecursiveDeref(manager, posVar);
+            checkedRef(wb, tmp);
+            Cudd_RecursiveDeref(manager, clueScores);
+            clueScores = tmp;
+        }
+    }
+
+    popCleanups(wb, 1);
+    return clueScores;
+}
+
+/* encodeCrosswordScores(wb, scores, cw)
+ *
+ * Returns an add giving the total score of each solution of cw (-infinity for
+ * non-solutions).
+ */
+static DdNode *encodeCrosswordScores(WordsBdd *wb, 
+                                     DdNode *scores, 
+                                     Crossword *cw) {
+    DdManager *manager = wb->manager;
+
+    DdNode *cwScores = Cudd_addConst(manager, 0.0);
+    checkedRef(wb, cwScores);
+    pushRef(wb, &cwScores);
+
+    for (int i = 0; i < cw->size; ++i) {
+        DdNode *clueScores = getClueScores(wb, 
+                                           scores, 
+                                           cw, 
+                                           &cw->clues[i], 
+                                           i);
+        DdNode *tmp = Cudd_addApply(manager, Cudd_addPlus, cwScores, clueScores);
+        Cudd_RecursiveDeref(manager, clueScores);
+        checkedRef(wb, tmp);
+        Cudd_RecursiveDeref(manager, cwScores);
+        cwScores = tmp;
+    }
+
+    popCleanups(wb, 1);
+    return cwScores;
+}
+
+/* enumerateTopSolutions(wb, cwBdd, scores, cw, k, callback, data)
+ *
+ * Calls callback with the k solutions with highest total score, best first,
+ * as in enumerateTopWords.  Returns non-zero if the callback stopped the
+ * enumeration.
+ */
+static int enumerateTopSolutions(WordsBdd *wb, 
+                                 DdNode *cwBdd, 
+                                 DdNode *scores,
+                                 Crossword *cw, 
+                                 int k,
+                                 SolutionCallback callback,
+                                 void *data) {
+    DdManager *manager = wb->manager;
+
+    int nvars = Cudd_ReadSize(manager);
+    char *cube = (char*)malloc(nvars);
+    pushCleanup(wb, freeCleanup, cube);
+    int *solution = (int*)malloc(nvars*sizeof(int));
+    pushCleanup(wb, freeCleanup, solution);
+    int *mask = getRelevanceMask(cw, nvars);
+    pushCleanup(wb, freeCleanup, mask);
+    char grid[MAX_WORD_SIZE][MAX_WORD_SIZE];
+    int found = 0;
+    int stop = 0;
+    double max;
+
+    DdNode *cwScores = encodeCrosswordScores(wb, scores, cw);
+    pushRef(wb, &cwScores);
+    DdNode *level = 0x00;
+    DdNode *remaining = 0x00;
+    pushRef(wb, &level);
+    pushRef(wb, &remaining);
+
+    while (found < k && (level = getMaxLevel(wb, cwScores, &max))) {
+        remaining = Cudd_bddAnd(manager, level, cwBdd);
+        checkedRef(wb, remaining);
+
+        while (found < k && !bddIsEmpty(wb, remaining)) {
+            if (!Cudd_bddPickOneCube(manager, remaining, cube))
+                resourceLimit(wb);
+            for (int i = 0; i < nvars; ++i)
+                solution[i] = (cube[i] == 1);
+            decodeSolution(solution, mask, nvars, cw, &grid);
+            found++;
+            if (callback(data, &grid, max)) {
+                stop = 1;
+                found = k;
+            }
+
+            DdNode *minterm = getSolutionMinterm(wb, cube, mask, nvars);
+            DdNode *tmp = Cudd_bddAnd(manager, remaining, Cudd_Not(minterm));
+            Cudd_RecursiveDeref(manager, minterm);
+            checkedRef(wb, tmp);
+            Cudd_RecursiveDeref(manager, remaining);
+            remaining = tmp;
+        }
+
+        Cudd_RecursiveDeref(manager, remaining);
+        remaining = 0x00;
+
+        DdNode *tmp = removeLevel(wb, cwScores, level);
+        Cudd_RecursiveDeref(manager, cwScores);
+        Cudd_RecursiveDeref(manager, level);
+        cwScores = tmp;
+        level = 0x00;
+    }
+
+    popCleanups(wb, 6);
+    Cudd_RecursiveDeref(manager, cwScores);
+    free(mask);
+    free(solution);
+    free(cube);
+    return stop;
+}
+
+/* getSolutionMinterm(wb, cube, mask, size)
+ *
+ * The bdd fixing every var in mask as in cube (don't cares taken as 0).
+ */
+static DdNode *getSolutionMinterm(WordsBdd *wb, 
+                                  char *cube, 
+                                  int *mask, 
+                                  int size) {
+    DdManager *manager = wb->manager;
+
+    DdNode *minterm = Cudd_ReadOne(manager);
+    Cudd_Ref(minterm);
+    pushRef(wb, &minterm);
+
+    for (int i = 0; i < size; ++i) {
+        if (!mask[i])
+            continue;
+        DdNode *b = Cudd_bddIthVar(manager, i);
+        DdNode *tmp = Cudd_bddAnd(manager, 
+                                  minterm, 
+                                  (cube[i] == 1) ? b : Cudd_Not(b));
+        checkedRef(wb, tmp);
+        Cudd_RecursiveDeref(manager, minterm);
+        minterm = tmp;
+    }
+
+    popCleanups(wb, 1);
+    return minterm;
+}
+
+static int *getRelevanceMask(Crossword* cw, int size) {
+    int *mask = (int*)malloc(size*sizeof(int));
+
+    for (int i = 0; i < size; ++i)
+        mask[i] = 0;
+
+    for (int i = 0; i < cw->size; ++i) {
+        int clueLen = strlen(cw->clues[i].pattern);
+        for (int pos = 0; pos < clueLen; ++pos) {
+            for (int b = 0; b < 8; ++b) {
+                int idx = getClueBddVarIndex(cw, &cw->clues[i], pos, b);
+                mask[idx] = 1;
+            }
+        }
+        for (int b = 0; b < 8; ++b) {
+            int idx = getClueBddEndVarIndex(i, b);
+            mask[idx] = 1;
+        }
+    }
+
+    return mask;
+}
+
+/* instantiateSolutionCube(cube, mask, i, size, cw, callback, data)
+ *
+ * Given a cube of length given by size, instantiate all cube[i] values of 2 to
+ * first 0 and then 1 if mask[i] is true, passing the results to callback in
+ * crossword form.  i is the index we've recursed down to.  Returns non-zero if
+ * the callback asked to stop.
+ */
+static int instantiateSolutionCube(int *cube, 
+                                   int *mask, 
+                                   int i, 
+                                   int size, 
+                                   Crossword *cw,
+                                   SolutionCallback callback,
+                                   void *data) {
+    int stop = 0;
+    if (i == size) {
+        char grid[MAX_WORD_SIZE][MAX_WORD_SIZE];
+        decodeSolution(cube, mask, size, cw, &grid);
+        stop = callback(data, &grid, 0.0);
+    } else if (!mask[i] || cube[i] != 2) {
+        stop = instantiateSolutionCube(cube, 
+                                       mask, 
+                                       i + 1, 
+                                       size, 
+                                       cw, 
+                                       callback, 
+                                       data);
+    } else {
+        cube[i] = 0;
+        stop = instantiateSolutionCube(cube, 
+                                       mask, 
+                                       i + 1, 
+                                       size, 
+                                       cw, 
+                                       callback, 
+                                       data);
+        cube[i] = 1;
+        if (!stop)
+            stop = instantiateSolutionCube(cube, 
+                                           mask, 
+                                           i + 1, 
+                                           size, 
+                                           cw, 
+                                           callback, 
+                                           data);
+        cube[i] = 2;
+    }
+    return stop;
+}
+
+/* decodeSolution(cube, mask, size, cw, grid)
+ *
+ * Fills grid with the letters of the solution in cube, 0x00 for squares not in
+ * any clue.
+ */
+static void decodeSolution(int *cube, 
+                           int *mask, 
+                           int size, 
+                           Crossword *cw,
+                           char (*grid)[MAX_WORD_SIZE][MAX_WORD_SIZE]) {
+    for (int y = 0; y < MAX_WORD_SIZE; ++y) {
+        for (int x = 0; x < MAX_WORD_SIZE; ++x) {
+            int charBegin = getCoordBddVarIndex(x, y, 0, cw);
+            char c = 0x00;
+            if (charBegin < size && mask[charBegin]) {
+                for (int b = 0; b < 8; ++b) {
+                    c = setBit(c, b, cube[getCoordBddVarIndex(x, y, b, cw)]);
+                }
+            }
+            (*grid)[y][x] = c;
+        }
+    }
+}
+
+
+/* fillCrossword(wb, dict, cw, seconds, maxFills, callback, data)
+ *
+ * Fills the empty squares of cw with words from dict by search, for large or
+ * mostly empty templates where conjoining every clue is hopeless.  Each slot
+ * keeps a bdd of the words that still fit it.  The search fills the slot with
+ * fewest words first, checks every crossing slot still has a word, and
+ * restarts with a larger backtrack limit when it gets stuck (words are picked
+ * at random, so each restart tries them in a new order).  Each distinct fill
+ * is passed to callback as it is found.  Stops after maxFills fills and after
+ * seconds (0 for no limit), or when every fill has been found.
+ */
+static void fillCrossword(WordsBdd *wb, 
+                          DdNode *dict, 
+                          Crossword *cw,
+                          double seconds,
+                          int maxFills,
+                          SolutionCallback callback,
+                          void *data) {
+    FillState fs;
+    memset(&fs, 0, sizeof(FillState));
+    fs.cw = cw;
+    fs.domains = (DdNode**)calloc(cw->size, sizeof(DdNode*));
+    fs.counts = (double*)malloc(cw->size * sizeof(double));
+    pushCleanup(wb, freeFillCleanup, &fs);
+    fs.maxFills = maxFills;
+    fs.deadline = (seconds > 0) ? wallTime() + seconds : 0;
+    fs.callback = callback;
+    fs.data = data;
+
+    // the template's letters, 0x00 for squares not in any clue
+    for (int i = 0; i < cw->size; ++i)
+        placeFillWord(&fs, &cw->clues[i], cw->clues[i].pattern);
+
+    int result = FILL_LIMIT;
+    for (int i = 0; i < cw->size; ++i) {
+        fs.domains[i] = matchPattern(wb, dict, cw->clues[i].pattern);
+        fs.counts[i] = getFillCount(wb, &fs, i);
+        if (fs.counts[i] == 0)
+            result = FILL_STOP;
+    }
+
+    beginPhase(wb, "fill");
+    fs.backtrackLimit = FILL_FIRST_BACKTRACKS;
+    while (result == FILL_LIMIT) {
+        fs.backtracks = 0;
+        result = fillSearch(wb, &fs);
+        fs.backtrackLimit *= FILL_RESTART_GROWTH;
+    }
+    endPhase(wb);
+
+    if (result == FILL_TIMEOUT)
+        logMsg(wb, "\nFill time budget reached.\n");
+
+    popCleanups(wb, 1);
+    freeFillCleanup(wb, &fs);
+}
+
+static void freeFillCleanup(WordsBdd *wb, void *fs) {
+    FillState *f = (FillState*)fs;
+    for (int i = 0; i < f->cw->size; ++i)
+        derefCleanup(wb, &f->domains[i]);
+    free(f->domains);
+    free(f->counts);
+    free(f->reported);
+}
+
+/* fillSearch(wb, fs)
+ *
+ * Fills the rest of fs->grid, returning FILL_EXHAUSTED if every way of doing
+ * so was tried, else FILL_LIMIT, FILL_TIMEOUT or FILL_STOP for why it gave
+ * up.  fs is as it was on return.
+ */
+static int fillSearch(WordsBdd *wb, FillState *fs) {
+    DdManager *manager = wb->manager;
+    Crossword *cw = fs->cw;
+
+    if (fillTimedOut(fs))
+        return FILL_TIMEOUT;
+
+    int slot = getFillSlot(fs);
+    if (slot < 0)
+        return reportFill(fs);
+
+    Clue *clue = &cw->clues[slot];
+    char pattern[MAX_WORD_SIZE];
+    char word[MAX_WORD_SIZE];
+    getSlotPattern(fs, clue, pattern);
+
+    char *cube = (char*)malloc(Cudd_ReadSize(manager));
+    pushCleanup(wb, freeCleanup, cube);
+
+    // on failure, deeper frames restore theirs first
+    FillFrame saved;
+    saved.fs = fs;
+    saved.domains = (DdNode**)malloc(cw->size * sizeof(DdNode*));
+    saved.counts = (double*)malloc(cw->size * sizeof(double));
+    memcpy(saved.domains, fs->domains, cw->size * sizeof(DdNode*));
+    memcpy(saved.counts, fs->counts, cw->size * sizeof(double));
+    pushCleanup(wb, restoreFillCleanup, &saved);
+
+    DdNode *remaining = fs->domains[slot];
+    Cudd_Ref(remaining);
+    pushRef(wb, &remaining);
+    int result = FILL_EXHAUSTED;
+
+    while (result == FILL_EXHAUSTED && !bddIsEmpty(wb, remaining)) {
+        // a slot can have many candidates that each fail fast
+        if (fillTimedOut(fs)) {
+            result = FILL_TIMEOUT;
+            break;
+        }
+
+        // cudd picks the branches at random
+        if (!Cudd_bddPickOneCube(manager, remaining, cube))
+            resourceLimit(wb);
+        decodeWordCube(cube, word);
+
+        DdNode *bddWord = getWord(wb, word);
+        DdNode *tmp = Cudd_bddAnd(manager, remaining, Cudd_Not(bddWord));
+        Cudd_RecursiveDeref(manager, bddWord);
+        checkedRef(wb, tmp);
+        Cudd_RecursiveDeref(manager, remaining);
+        remaining = tmp;
+
+        if (fillUsesWord(fs, word))
+            continue;
+
+        placeFillWord(fs, clue, word);
+        if (forwardCheck(wb, fs, slot))
+            result = fillSearch(wb, fs);
+
+        restoreFillDomains(wb, &saved);
+        placeFillWord(fs, clue, pattern);
+
+        if (result == FILL_EXHAUSTED && ++fs->backtracks > fs->backtrackLimit)
+            result = FILL_LIMIT;
+    }
+
+    popCleanups(wb, 3);
+    Cudd_RecursiveDeref(manager, remaining);
+    free(saved.counts);
+    free(saved.domains);
+    free(cube);
+
+    return result;
+}
+
+static int fillTimedOut(FillState *fs) {
+    return fs->deadline > 0 && wallTime() >= fs->deadline;
+}
+
+/* restoreFillDomains(wb, saved)
+ *
+ * Puts back the domains and counts saved by a fillSearch frame, releasing
+ * any narrowed since.
+ */
+static void restoreFillDomains(WordsBdd *wb, FillFrame *saved) {
+    FillState *fs = saved->fs;
+    for (int i = 0; i < fs->cw->size; ++i) {
+        if (fs->domains[i] != saved->domains[i])
+            Cudd_RecursiveDeref(wb->manager, fs->domains[i]);
+    }
+    memcpy(fs->domains, saved->domains, fs->cw->size * sizeof(DdNode*));
+    memcpy(fs->counts, saved->counts, fs->cw->size * sizeof(double));
+}
+
+static void restoreFillCleanup(WordsBdd *wb, void *saved) {
+    FillFrame *s = (FillFrame*)saved;
+    restoreFillDomains(wb, s);
+    free(s->domains);
+    free(s->counts);
+}
+
+/* forwardCheck(wb, fs, slot)
+ *
+ * Narrows the domains of the unfilled slots crossing slot to the letters now
+ * placed.  Returns 0 if any is left without a word.
+ */
+static int forwardCheck(WordsBdd *wb, FillState *fs, int slot) {
+    DdManager *manager = wb->manager;
+    Crossword *cw = fs->cw;
+    char pattern[MAX_WORD_SIZE];
+
+    for (int i = 0; i < cw->size; ++i) {
+        if (i == slot || !cluesCross(&cw->clues[i], &cw->clues[slot]))
+            continue;
+
+        getSlotPattern(fs, &cw->clues[i], pattern);
+        DdNode *bddPat = getWordWildcards(wb, pattern);
+        DdNode *tmp = Cudd_bddAnd(manager, fs->domains[i], bddPat);
+        Cudd_RecursiveDeref(manager, bddPat);
+        checkedRef(wb, tmp);
+        // no new letter in it, and fillSearch only releases changed domains
+        if (tmp == fs->domains[i]) {
+            Cudd_RecursiveDeref(manager, tmp);
+            continue;
+        }
+        // the old domain is restored by fillSearch
+        fs->domains[i] = tmp;
+        fs->counts[i] = getFillCount(wb, fs, i);
+
+        if (fs->counts[i] == 0)
+            return 0;
+    }
+
+    return 1;
+}
+
+/* getFillSlot(fs)
+ *
+ * The unfilled slot with fewest fitting words, or -1 if all are filled.
+ */
+static int getFillSlot(FillState *fs) {
+    char pattern[MAX_WORD_SIZE];
+    int best = -1;
+
+    for (int i = 0; i < fs->cw->size; ++i) {
+        getSlotPattern(fs, &fs->cw->clues[i], pattern);
+        if (strchr(pattern, ANY_CHAR) == 0x00)
+            continue;
+        if (best < 0 || fs->counts[i] < fs->counts[best])
+            best = i;
+    }
+
+    return best;
+}
+
+static double getFillCount(WordsBdd *wb, FillState *fs, int slot) {
+    int len = strlen(fs->cw->clues[slot].pattern);
+    return countWords(wb, fs->domains[slot], len);
+}
+
+/* reportFill(fs)
+ *
+ * Passes the now complete fs->grid to the callback unless it repeats a word
+ * or was reported before (by an earlier restart).  Returns FILL_STOP if no
+ * more fills are wanted, else FILL_EXHAUSTED.
+ */
+static int reportFill(FillState *fs) {
+    char pattern[MAX_WORD_SIZE];
+    char other[MAX_WORD_SIZE];
+
+    for (int i = 0; i < fs->cw->size; ++i) {
+        getSlotPattern(fs, &fs->cw->clues[i], pattern);
+        for (int j = i + 1; j < fs->cw->size; ++j) {
+            getSlotPattern(fs, &fs->cw->clues[j], other);
+            if (strcmp(pattern, other) == 0)
+                return FILL_EXHAUSTED;
+        }
+    }
+
+    for (int i = 0; i < fs->numReported; ++i) {
+        if (memcmp(fs->reported[i], fs->grid, sizeof(fs->grid)) == 0)
+            return FILL_EXHAUSTED;
+    }
+
+    fs->reported = realloc(fs->reported, 
+                           (fs->numReported + 1) * sizeof(fs->grid));
+    memcpy(fs->reported[fs->numReported++], fs->grid, sizeof(fs->grid));
+
+    if (fs->callback(fs->data, &fs->grid, 0.0))
+        return FILL_STOP;
+    if (fs->maxFills > 0 && fs->numReported >= fs->maxFills)
+        return FILL_STOP;
+
+    return FILL_EXHAUSTED;
+}
+
+/* fillUsesWord(fs, word)
+ *
+ * Whether word already fills a slot of fs.
+ */
+static int fillUsesWord(FillState *fs, char *word) {
+    char pattern[MAX_WORD_SIZE];
+
+    for (int i = 0; i < fs->cw->size; ++i) {
+        getSlotPattern(fs, &fs->cw->clues[i], pattern);
+        if (strcmp(pattern, word) == 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+static void getSlotPattern(FillState *fs, Clue *clue, char *pattern) {
+    int len = strlen(clue->pattern);
+    for (int pos = 0; pos < len; ++pos) {
+        if (clue->across)
+            pattern[pos] = fs->grid[clue->y][clue->x + pos];
+        else
+            pattern[pos] = fs->grid[clue->y + pos][clue->x];
+    }
+    pattern[len] = 0x00;
+}
+
+static void placeFillWord(FillState *fs, Clue *clue, char *word) {
+    int len = strlen(clue->pattern);
+    for (int pos = 0; pos < len; ++pos) {
+        if (clue->across)
+            fs->grid[clue->y][clue->x + pos] = word[pos];
+        else
+            fs->grid[clue->y + pos][clue->x] = word[pos];
+    }
+}
+
+
+static int acrossStart(char (*grid)[MAX_WORD_SIZE][MAX_WORD_SIZE], int x, int y) {
+    return (x == 0 && 
+            x < MAX_WORD_SIZE - 1 && 
+            y >= 0 &&
+            y < MAX_WORD_SIZE &&
+            isOccupying((*grid)[x][y]) && 
+            isOccupying((*grid)[x + 1][y])) ||
+           (x > 0 && 
+            x < MAX_WORD_SIZE && 
+            y >= 0 &&
+            y < MAX_WORD_SIZE &&
+            !isOccupying((*grid)[x - 1][y]) &&
+            isOccupying((*grid)[x][y]) && 
+            isOccupying((*grid)[x + 1][y])); 
+}
+
+static int downStart(char (*grid)[MAX_WORD_SIZE][MAX_WORD_SIZE], int x, int y) {
+    return (y == 0 && 
+            y < MAX_WORD_SIZE - 1 && 
+            x >= 0 &&
+            x < MAX_WORD_SIZE &&
+            isOccupying((*grid)[x][y]) && 
+            isOccupying((*grid)[x][y + 1])) ||
+           (y > 0 && 
+            y < MAX_WORD_SIZE && 
+            x >= 0 &&
+            x < MAX_WORD_SIZE &&
+            !isOccupying((*grid)[x][y - 1]) &&
+            isOccupying((*grid)[x][y]) && 
+            isOccupying((*grid)[x][y + 1])); 
+}
+
+
+static int isOccupying(char c) {
+    return isalpha(c) || c == ANY_CHAR;
+}
+
+static void getAcrossPattern(char (*grid)[MAX_WORD_SIZE][MAX_WORD_SIZE], 
+                             int x,
+                             int y,
+                             char *pattern) {
+    int i = 0;
+    while (x < MAX_WORD_SIZE && isOccupying((*grid)[x][y])) 
+        pattern[i++] = (*grid)[x++][y];
+    pattern[i] = 0x00;
+}
+
+static void getDownPattern(char (*grid)[MAX_WORD_SIZE][MAX_WORD_SIZE], 
+                           int x,
+                           int y,
+                           char *pattern) {
+    int i = 0;
+    while (y < MAX_WORD_SIZE && isOccupying((*grid)[x][y])) 
+        pattern[i++] = (*grid)[x][y++];
+    pattern[i] = 0x00;
+}
+
+
+
+/* addNamedDict(wb, name, bdd)
+ *
+ * Adds a loaded language for use in expressions.  All languages live in the
+ * one manager, so they share nodes.  The first one becomes the dictionary.
+ */
+static void addNamedDict(WordsBdd *wb, char *name, DdNode *bdd) {
+    char *error = 0x00;
+    if (wb->numDicts >= MAX_DICTS)
+        error = "Too many languages";
+    else if (strlen(name) >= MAX_DICT_NAME_SIZE)
+        error = "Language name too long";
+    else if (getNamedDict(wb, name))
+        error = "Language given twice";
+
+    if (error) {
+        Cudd_RecursiveDeref(wb->manager, bdd);
+        fail(wb, WB_ERROR, "%s: %s.", error, name);
+    }
+
+    NamedDict *d = &wb->dicts[wb->numDicts++];
+    strcpy(d->name, name);
+    d->bdd = bdd;
+
+    if (wb->dict == 0x00)
+        wb->dict = bdd;
+}
+
+static NamedDict *getNamedDict(WordsBdd *wb, char *name) {
+    for (int i = 0; i < wb->numDicts; ++i) {
+        if (strcmp(wb->dicts[i].name, name) == 0)
+            return &wb->dicts[i];
+    }
+    return 0x00;
+}
+
+
+/* evalDictExpr(wb, expr)
+ *
+ * Returns the language given by expr over the named languages, e.g.
+ *
+ *     general | themed - banned
+ *
+ * & binds tighter than | and -, which associate to the left.  The last
+ * MAX_CACHED_EXPRS results are cached by expression (ignoring spaces), so
+ * switching between them does not build them again.  The cache owns the
+ * result, which is what keeps wb->dict referenced.
+ */
+static DdNode *evalDictExpr(WordsBdd *wb, char *expr) {
+    char norm[MAX_EXPR_SIZE];
+    int len = 0;
+
+    for (int i = 0; expr[i] != 0x00; ++i) {
+        if (isspace(expr[i]))
+            continue;
+        if (len >= MAX_EXPR_SIZE - 1)
+            fail(wb, WB_ERROR, "Language expression %s too long.", expr);
+        norm[len++] = expr[i];
+    }
+    norm[len] = 0x00;
+
+    for (int i = 0; i < wb->numCachedExprs; ++i) {
+        if (strcmp(wb->exprCache[i].expr, norm) == 0)
+            return wb->exprCache[i].bdd;
+    }
+
+    char *pos = norm;
+    DdNode *bdd = parseDictUnion(wb, &pos);
+    if (*pos != 0x00) {
+        Cudd_RecursiveDeref(wb->manager, bdd);
+        dictExprError(wb, pos, "unexpected character");
+    }
+
+    // cache full, so forget the oldest (wb->dict is about to be replaced)
+    if (wb->numCachedExprs == MAX_CACHED_EXPRS) {
+        Cudd_RecursiveDeref(wb->manager, wb->exprCache[0].bdd);
+        memmove(wb->exprCache, 
+                wb->exprCache + 1, 
+                (MAX_CACHED_EXPRS - 1) * sizeof(CachedExpr));
+        wb->numCachedExprs--;
+    }
+    strcpy(wb->exprCache[wb->numCachedExprs].expr, norm);
+    wb->exprCache[wb->numCachedExprs].bdd = bdd;
+    wb->numCachedExprs++;
+
+    return bdd;
+}
+
+static DdNode *parseDictUnion(WordsBdd *wb, char **pos) {
+    DdManager *manager = wb->manager;
+
+    DdNode *bdd = parseDictIntersect(wb, pos);
+    pushRef(wb, &bdd);
+
+    while (**pos == EXPR_UNION || **pos == EXPR_MINUS) {
+        char op = *(*pos)++;
+        DdNode *rhs = parseDictIntersect(wb, pos);
+        DdNode *tmp;
+        if (op == EXPR_UNION)
+            tmp = Cudd_bddOr(manager, bdd, rhs);
+        else
+            tmp = Cudd_bddAnd(manager, bdd, Cudd_Not(rhs));
+        Cudd_RecursiveDeref(manager, rhs);
+        checkedRef(wb, tmp);
+        Cudd_RecursiveDeref(manager, bdd);
+        bdd = tmp;
+    }
+
+    popCleanups(wb, 1);
+    return bdd;
+}
+
+static DdNode *parseDictIntersect(WordsBdd *wb, char **pos) {
+    DdManager *manager = wb->manager;
+
+    DdNode *bdd = parseDictTerm(wb, pos);
+    pushRef(wb, &bdd);
+
+    while (**pos == EXPR_INTERSECT) {
+        (*pos)++;
+        DdNode *rhs = parseDictTerm(wb, pos);
+        DdNode *tmp = Cudd_bddAnd(manager, bdd, rhs);
+        Cudd_RecursiveDeref(manager, rhs);
+        checkedRef(wb, tmp);
+        Cudd_RecursiveDeref(manager, bdd);
+        bdd = tmp;
+    }
+
+    popCleanups(wb, 1);
+    return bdd;
+}
+
+static DdNode *parseDictTerm(WordsBdd *wb, char **pos) {
+    if (**pos == '(') {
+        (*pos)++;
+        DdNode *bdd = parseDictUnion(wb, pos);
+        if (**pos != ')') {
+            Cudd_RecursiveDeref(wb->manager, bdd);
+            dictExprError(wb, *pos, "expected )");
+        }
+        (*pos)++;
+        return bdd;
+    }
+
+    char name[MAX_DICT_NAME_SIZE];
+    int len = 0;
+    while ((isalnum(**pos) || **pos == '_') && len < MAX_DICT_NAME_SIZE - 1)
+        name[len++] = *(*pos)++;
+    name[len] = 0x00;
+
+    if (len == 0)
+        dictExprError(wb, *pos, "expected language name");
+
+    NamedDict *d = getNamedDict(wb, name);
+    if (d == 0x00)
+        fail(wb, WB_ERROR, "Unknown language %s in expression.", name);
+
+    Cudd_Ref(d->bdd);
+    return d->bdd;
+}
+
+static void dictExprError(WordsBdd *wb, char *pos, char *msg) {
+    fail(wb, 
+         WB_ERROR, 
+         "Error in language expression at \"%s\": %s.", 
+         pos, 
+         msg);
+}
+
+
+/* beginPhase(wb, name)
+ *
+ * Starts timing a phase for the statistics report.  Phases do not nest, and
+ * repeated phases of the same name are summed.
+ */
+static void beginPhase(WordsBdd *wb, char *name) {
+    wb->curPhase = 0x00;
+    for (int i = 0; i < wb->numPhases && !wb->curPhase; ++i) {
+        if (strcmp(wb->phases[i].name, name) == 0)
+            wb->curPhase = &wb->phases[i];
+    }
+
+    // if out of room, the phase just isn't recorded
+    if (!wb->curPhase && wb->numPhases < MAX_PHASES) {
+        wb->curPhase = &wb->phases[wb->numPhases++];
+        strncpy(wb->curPhase->name, name, MAX_PHASE_NAME_SIZE - 1);
+    }
+
+    wb->curPhaseWall = wallTime();
+    wb->curPhaseCpu = clock();
+}
+
+static void endPhase(WordsBdd *wb) {
+    DdManager *manager = wb->manager;
+
+    if (!wb->curPhase)
+        return;
+
+    wb->curPhase->calls++;
+    wb->curPhase->wall += wallTime() - wb->curPhaseWall;
+    wb->curPhase->cpu += (double)(clock() - wb->curPhaseCpu) / CLOCKS_PER_SEC;
+    wb->curPhase->nodes = Cudd_ReadNodeCount(manager);
+    wb->curPhase = 0x00;
+}
+
+static double wallTime() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/* wbWriteStats(wb, format, f)
+ *
+ * Writes the phase timings and cudd statistics so far to f, format is
+ * STATS_TEXT or STATS_JSON.
+ */
+void wbWriteStats(WordsBdd *wb, char *format, FILE *f) {
+    if (strcmp(format, STATS_JSON) == 0)
+        writeStatsJson(wb, f);
+    else
+        writeStatsText(wb, f);
+}
+
+/* writeStatsText(wb, f)
+ *
+ * Unique table lookups and links are only counted if cudd was compiled with
+ * DD_UNIQUE_PROFILE, and are -1 otherwise.
+ */
+static void writeStatsText(WordsBdd *wb, FILE *f) {
+    DdManager *manager = wb->manager;
+
+    // -1 unless cudd was built with DD_UNIQUE_PROFILE
+    double uniqueLookups = Cudd_ReadUniqueLookUps(manager);
+    double uniqueLinks = Cudd_ReadUniqueLinks(manager);
+
+    fprintf(f, "\nStatistics:\n\n");
+    fprintf(f, "%-24s %8s %12s %12s %12s\n", 
+            "phase", "calls", "wall (s)", "cpu (s)", "live nodes");
+    for (int i = 0; i < wb->numPhases; ++i) {
+        fprintf(f, "%-24s %8d %12.6f %12.6f %12ld\n",
+                wb->phases[i].name,
+                wb->phases[i].calls,
+                wb->phases[i].wall,
+                wb->phases[i].cpu,
+                wb->phases[i].nodes);
+    }
+    fprintf(f, "\n");
+    fprintf(f, "peak live nodes:         %d\n", 
+            Cudd_ReadPeakLiveNodeCount(manager));
+    fprintf(f, "peak nodes:              %ld\n", 
+            Cudd_ReadPeakNodeCount(manager));
+    fprintf(f, "live nodes:              %ld\n", 
+            Cudd_ReadNodeCount(manager));
+    fprintf(f, "variables:               %d\n", 
+            Cudd_ReadSize(manager));
+    fprintf(f, "unique table slots:      %u\n", 
+            Cudd_ReadSlots(manager));
+    fprintf(f, "unique table keys:       %u\n", 
+            Cudd_ReadKeys(manager));
+    if (uniqueLookups < 0) {
+        fprintf(f, "unique table lookups:    n/a\n");
+        fprintf(f, "unique links per lookup: n/a\n");
+    } else {
+        fprintf(f, "unique table lookups:    %.0f\n", uniqueLookups);
+        fprintf(f, "unique links per lookup: %f\n", 
+                getRatio(uniqueLinks, uniqueLookups));
+    }
+    fprintf(f, "computed table slots:    %u\n", 
+            Cudd_ReadCacheSlots(manager));
+    fprintf(f, "computed table lookups:  %.0f\n", 
+            Cudd_ReadCacheLookUps(manager));
+    fprintf(f, "computed table hit rate: %f\n", 
+            getRatio(Cudd_ReadCacheHits(manager), 
+                     Cudd_ReadCacheLookUps(manager)));
+    fprintf(f, "garbage collections:     %d\n", 
+            Cudd_ReadGarbageCollections(manager));
+    fprintf(f, "gc time (ms):            %ld\n", 
+            Cudd_ReadGarbageCollectionTime(manager));
+    fprintf(f, "reorderings:             %u\n", 
+            Cudd_ReadReorderings(manager));
+    fprintf(f, "bdd memory (bytes):      %lu\n", 
+            Cudd_ReadMemoryInUse(manager));
+    fprintf(f, "peak rss (kb):           %ld\n", 
+            getPeakRss());
+}
+
+static void writeStatsJson(WordsBdd *wb, FILE *f) {
+    DdManager *manager = wb->manager;
+
+    double uniqueLookups = Cudd_ReadUniqueLookUps(manager);
+    double uniqueLinks = Cudd_ReadUniqueLinks(manager);
+
+    fprintf(f, "{\"phases\": [");
+    for (int i = 0; i < wb->numPhases; ++i) {
+        fprintf(f, "%s{\"name\": \"%s\", \"calls\": %d, "
+                   "\"wall\": %f, \"cpu\": %f, \"nodes\": %ld}",
+                (i > 0 ? ", " : ""),
+                wb->phases[i].name,
+                wb->phases[i].calls,
+                wb->phases[i].wall,
+                wb->phases[i].cpu,
+                wb->phases[i].nodes);
+    }
+    fprintf(f, "], ");
+    fprintf(f, "\"peakLiveNodes\": %d, ", 
+            Cudd_ReadPeakLiveNodeCount(manager));
+    fprintf(f, "\"peakNodes\": %ld, ", 
+            Cudd_ReadPeakNodeCount(manager));
+    fprintf(f, "\"liveNodes\": %ld, ", 
+            Cudd_ReadNodeCount(manager));
+    fprintf(f, "\"variables\": %d, ", 
+            Cudd_ReadSize(manager));
+    fprintf(f, "\"uniqueSlots\": %u, ", 
+            Cudd_ReadSlots(manager));
+    fprintf(f, "\"uniqueKeys\": %u, ", 
+            Cudd_ReadKeys(manager));
+    if (uniqueLookups < 0) {
+        fprintf(f, "\"uniqueLookups\": null, ");
+        fprintf(f, "\"uniqueLinksPerLookup\": null, ");
+    } else {
+        fprintf(f, "\"uniqueLookups\": %.0f, ", uniqueLookups);
+        fprintf(f, "\"uniqueLinksPerLookup\": %f, ", 
+                getRatio(uniqueLinks, uniqueLookups));
+    }
+    fprintf(f, "\"cacheSlots\": %u, ", 
+            Cudd_ReadCacheSlots(manager));
+    fprintf(f, "\"cacheLookups\": %.0f, ", 
+            Cudd_ReadCacheLookUps(manager));
+    fprintf(f, "\"cacheHitRate\": %f, ", 
+            getRatio(Cudd_ReadCacheHits(manager), 
+                     Cudd_ReadCacheLookUps(manager)));
+    fprintf(f, "\"garbageCollections\": %d, ", 
+            Cudd_ReadGarbageCollections(manager));
+    fprintf(f, "\"gcTimeMs\": %ld, ", 
+            Cudd_ReadGarbageCollectionTime(manager));
+    fprintf(f, "\"reorderings\": %u, ", 
+            Cudd_ReadReorderings(manager));
+    fprintf(f, "\"memoryInUse\": %lu, ", 
+            Cudd_ReadMemoryInUse(manager));
+    fprintf(f, "\"peakRssKb\": %ld}\n", 
+            getPeakRss());
+}
+
+static double getRatio(double num, double denom) {
+    return (denom > 0) ? num / denom : 0.0;
+}
+
+static long getPeakRss() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+    return usage.ru_maxrss;
+}
+
+
+/* checkedRef(wb, node)
+ *
+ * References the result of a cudd operation, failing with WB_RESOURCE_LIMIT
+ * if the operation failed.
+ */
+static void checkedRef(WordsBdd *wb, DdNode *node) {
+    if (node == 0x00)
+        resourceLimit(wb);
+    Cudd_Ref(node);
+}
+
+static void resourceLimit(WordsBdd *wb) {
+    DdManager *manager = wb->manager;
+
+    char *reason;
+    switch (Cudd_ReadErrorCode(manager)) {
+    case CUDD_MEMORY_OUT:
+        reason = "out of memory";
+        break;
+    case CUDD_TOO_MANY_NODES:
+        reason = "too many live nodes for the memory limit";
+        break;
+    default:
+        reason = "bdd operation failed";
+        break;
+    }
+
+    Cudd_ClearErrorCode(manager);
+    fail(wb, WB_RESOURCE_LIMIT, "Resource limit: %s.", reason);
+}
@@ -0,0 +1,209 @@
+#ifndef WORDS_BDD_H
+#define WORDS_BDD_H
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "util.h"
+#include "cudd.h"
+#include "dddmp.h"
+
+#define MAX_WORD_SIZE 25
+#define RAW_FORMAT "%c %d %d %25s\n"
+#define DIR_ACROSS 'A'
+#define DIR_DOWN 'D'
+#define ANY_CHAR '*'
+#define MAX_DICTS 16
+#define MAX_DICT_NAME_SIZE 32
+#define MAX_CACHED_EXPRS 16
+#define MAX_EXPR_SIZE 256
+#define DEFAULT_DICT_NAME "dict"
+#define EXPR_UNION '|'
+#define EXPR_INTERSECT '&'
+#define EXPR_MINUS '-'
+#define MAX_PHASES 256
+#define MAX_PHASE_NAME_SIZE 32
+#define STATS_TEXT "text"
+#define STATS_JSON "json"
+#define RESOURCE_LIMIT_STATUS 3
+// rough bytes per live node, including its share of the unique table
+#define BYTES_PER_NODE 40
+#define MAX_ERROR_SIZE 256
+// things a failing wb* call has to release, see pushCleanup
+#define MAX_CLEANUPS 1024
+// status returned by the wb* functions
+#define WB_OK 0
+#define WB_ERROR 1
+#define WB_RESOURCE_LIMIT 2
+// word file reading, see loadWords
+#define INGEST_CHUNK_SIZE (1 << 20)
+#define WORD_BATCH_SIZE 1024
+#define STDIN_FILE "-"
+// dictionary container, see writeBddDict
+#define DICT_MAGIC "WBDD"
+#define DICT_MAGIC_SIZE 4
+#define DICT_VERSION 1
+#define DICT_HEADER_SIZE 32
+#define DICT_COMPRESSED 1
+#define DICT_MAX_SIZE 0xffffffffUL
+#define DICT_READ_CHUNK 65536
+// how plain dddmp files (from before the container) start
+#define DDDMP_MAGIC ".ver"
+#define DDDMP_MAGIC_SIZE 4
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+#define LZ_HASH_BITS 14
+#define LZ_HASH_SIZE (1 << LZ_HASH_BITS)
+// backtracks before the first grid fill restart, multiplied on each restart
+#define FILL_FIRST_BACKTRACKS 100
+#define FILL_RESTART_GROWTH 2
+// fillSearch results
+#define FILL_EXHAUSTED 0
+#define FILL_LIMIT 1
+#define FILL_TIMEOUT 2
+#define FILL_STOP 3
+
+
+typedef struct {
+    int across;
+    int x;
+    int y;
+    char pattern[MAX_WORD_SIZE];
+} Clue;
+
+typedef struct {
+    int size;
+    Clue *clues;
+} Crossword;
+
+typedef struct {
+    char name[MAX_DICT_NAME_SIZE];
+    DdNode *bdd;
+} NamedDict;
+
+typedef struct {
+    char expr[MAX_EXPR_SIZE];
+    DdNode *bdd;
+} CachedExpr;
+
+typedef struct {
+    char name[MAX_PHASE_NAME_SIZE];
+    int calls;
+    double wall; // seconds
+    double cpu; // seconds
+    long nodes; // live nodes at end of last call
+} Phase;
+
+struct WordsBdd;
+
+typedef void (*CleanupFunction)(struct WordsBdd *wb, void *arg);
+
+typedef struct {
+    CleanupFunction function;
+    void *arg;
+} Cleanup;
+
+/* A words_bdd context: one cudd manager holding the named languages, the
+ * dictionary queries run against, the word scores and the statistics.  Made
+ * by wbNew, freed by wbFree.  Contexts are independent, but each must only be
+ * used by one thread at a time.
+ */
+typedef struct WordsBdd {
+    DdManager *manager;
+    DdNode *dict; // not referenced separately, belongs to dicts or exprCache
+    DdNode *scores; // 0x00 until loaded or first needed
+    int defaultScores; // = 1 if scores were made by getScores
+    FILE *log; // progress messages, 0x00 for none
+    int compress; // = 1 to compress saved dictionaries (the default)
+
+    // word file normalization, see normalizeWord
+    int foldCase; // default 1
+    int stripAccents;
+    int stripPunct;
+    int minLength; // default 1
+    int maxLength; // default MAX_WORD_SIZE - 1
+
+    // over every word file loaded, which can pass 2^31 chars
+    long long totalChars;
+    long long totalWords;
+
+    NamedDict dicts[MAX_DICTS];
+    int numDicts;
+    CachedExpr exprCache[MAX_CACHED_EXPRS];
+    int numCachedExprs;
+
+    Phase phases[MAX_PHASES];
+    int numPhases;
+    Phase *curPhase;
+    double curPhaseWall;
+    clock_t curPhaseCpu;
+
+    jmp_buf onError;
+    int status;
+    char error[MAX_ERROR_SIZE];
+    // run by fail, newest first, so always empty between wb* calls
+    Cleanup cleanups[MAX_CLEANUPS];
+    int numCleanups;
+} WordsBdd;
+
+/* Called with each match (score is 0 unless ranking), return non-zero to stop
+ * the enumeration.  word is only valid during the call.
+ */
+typedef int (*WordCallback)(void *data, char *word, double score);
+
+/* Called with each crossword solution, grid[y][x] is the letter at x, y or
+ * 0x00 if not part of a clue.  Return non-zero to stop.
+ */
+typedef int (*SolutionCallback)(void *data, 
+                                char (*grid)[MAX_WORD_SIZE][MAX_WORD_SIZE], 
+                                double score);
+
+
+/* Library interface.  All but wbNew, wbFree, wbWriteStats, wbFreeCrossword
+ * and wbError return WB_OK or an error status, with the message in
+ * wbError(wb).  The helpers behind them are static, see words_bdd_internal.h.
+ */
+WordsBdd *wbNew(unsigned long maxMemory, 
+                unsigned int uniqueSlots, 
+                unsigned int cacheSlots);
+void wbFree(WordsBdd *wb);
+int wbLoadWords(WordsBdd *wb, char *name, char *wordsFile, int withScores);
+int wbLoadBdd(WordsBdd *wb, char *name, char *bddFile);
+int wbLoadScores(WordsBdd *wb, char *scoresFile);
+int wbUseDict(WordsBdd *wb, char *expr);
+int wbSaveBdd(WordsBdd *wb, char *bddFile);
+int wbSaveScores(WordsBdd *wb, char *scoresFile);
+int wbSaveDot(WordsBdd *wb, char *dotFile);
+int wbMatchPattern(WordsBdd *wb, 
+                   char *pattern, 
+                   int topK, 
+                   WordCallback callback, 
+                   void *data);
+int wbMatchFuzzy(WordsBdd *wb, 
+                 char *word, 
+                 int topK, 
+                 WordCallback callback, 
+                 void *data);
+int wbCountPattern(WordsBdd *wb, char *pattern, double *count);
+int wbReadCrossword(WordsBdd *wb, 
+                    char *crosswordFile, 
+                    int rawFormat, 
+                    Crossword *cw);
+int wbSolveCrossword(WordsBdd *wb, 
+                     Crossword *cw, 
+                     int topK, 
+                     SolutionCallback callback, 
+                     void *data);
+int wbCountSolutions(WordsBdd *wb, Crossword *cw, double *count);
+int wbFillCrossword(WordsBdd *wb, 
+                    Crossword *cw, 
+                    double seconds,
+                    int maxFills,
+                    SolutionCallback callback, 
+                    void *data);
+void wbWriteStats(WordsBdd *wb, char *format, FILE *f);
+void wbFreeCrossword(Crossword *cw);
+char *wbError(WordsBdd *wb);
+
+#endif
@@ -0,0 +1,283 @@
+#ifndef WORDS_BDD_INTERNAL_H
+#define WORDS_BDD_INTERNAL_H
+
+#include "words_bdd.h"
+
+/* Only included by words_bdd.c.  Everything here is static, so the library
+ * exports nothing but the wb* functions.
+ */
+
+/* Words read by loadWords but not yet added to dict. */
+typedef struct {
+    char words[WORD_BATCH_SIZE][MAX_WORD_SIZE];
+    double wordScores[WORD_BATCH_SIZE];
+    int size;
+    DdNode *dict;
+    DdNode **scores; // 0x00 if not wanted
+} WordBatch;
+
+/* Grid fill search state, see fillCrossword. */
+typedef struct {
+    Crossword *cw;
+    char grid[MAX_WORD_SIZE][MAX_WORD_SIZE]; // letters or ANY_CHAR
+    DdNode **domains; // words that still fit each clue
+    double *counts; // number of words in each domain
+    long backtracks;
+    long backtrackLimit;
+    double deadline; // wallTime to give up at, 0 for none
+    int maxFills; // 0 for no limit
+    char (*reported)[MAX_WORD_SIZE][MAX_WORD_SIZE];
+    int numReported;
+    SolutionCallback callback;
+    void *data;
+} FillState;
+
+/* The domains a fillSearch frame restores when it backtracks. */
+typedef struct {
+    FillState *fs;
+    DdNode **domains;
+    double *counts;
+} FillFrame;
+
+/* A solution kept by solveCrosswordSplit for its top k. */
+typedef struct {
+    double score;
+    char grid[MAX_WORD_SIZE][MAX_WORD_SIZE];
+} TopSolution;
+
+typedef struct {
+    TopSolution *best; // heap, worst first
+    int size;
+    int k;
+} TopSolutions;
+
+/* A clue's own pattern while solveCrosswordSplit puts words in it. */
+typedef struct {
+    Clue *clue;
+    char pattern[MAX_WORD_SIZE];
+} SavedPattern;
+
+
+static void fail(WordsBdd *wb, int status, char *format, ...);
+static void pushCleanup(WordsBdd *wb, CleanupFunction function, void *arg);
+static void pushRef(WordsBdd *wb, DdNode **node);
+static void popCleanups(WordsBdd *wb, int n);
+static void derefCleanup(WordsBdd *wb, void *node);
+static void freeCleanup(WordsBdd *wb, void *p);
+static void logMsg(WordsBdd *wb, char *format, ...);
+static DdNode *getDict(WordsBdd *wb);
+static DdNode *getScores(WordsBdd *wb);
+static void setScores(WordsBdd *wb, DdNode *scores);
+static void coverScores(WordsBdd *wb);
+
+static DdNode *addWord(WordsBdd *wb, DdNode *dict, char *word);
+static DdNode *getWord(WordsBdd *wb, char* word);
+static DdNode *getWordWildcards(WordsBdd *wb, char* word);
+static DdNode *addChar(WordsBdd *wb, DdNode *bddWord, char c, int i);
+static DdNode *addNonNull(WordsBdd *wb, DdNode *bddWord, int i);
+static void writeDotDict(WordsBdd *wb, DdNode *dict, char *outFile);
+static DdNode *loadWords(WordsBdd *wb, char *wordsFile, DdNode **scores);
+static void closeWordsCleanup(WordsBdd *wb, void *f);
+static int addLine(WordsBdd *wb, WordBatch *batch, char *line, long len);
+static int normalizeWord(WordsBdd *wb, char *raw, long len, char *word);
+static void addWordBatch(WordsBdd *wb, WordBatch *batch);
+static void derefBatchCleanup(WordsBdd *wb, void *bdds);
+static DdNode *getWordScore(WordsBdd *wb, DdNode *bddWord, double score);
+static DdNode *getDefaultScores(WordsBdd *wb, DdNode *dict);
+static DdNode *loadScores(WordsBdd *wb, char *scoresInFile);
+static void writeScores(WordsBdd *wb, DdNode *scores, char *scoresOutFile);
+static void writeSummary(WordsBdd *wb, DdNode *dict);
+static DdNode *matchPattern(WordsBdd *wb, DdNode *dict, char *pattern);
+static double countWords(WordsBdd *wb, DdNode *bdd, int len);
+static DdNode *matchFuzzy(WordsBdd *wb, DdNode *dict, char *word);
+static DdNode *getFuzzyNeighbourhood(WordsBdd *wb, char *word);
+static DdNode *orPattern(WordsBdd *wb, DdNode *bdd, char *pattern);
+static int enumerateWords(WordsBdd *wb, 
+                          DdNode *dict, 
+                          WordCallback callback, 
+                          void *data);
+static void enumerateMatches(WordsBdd *wb, 
+                             DdNode *match, 
+                             int topK,
+                             WordCallback callback, 
+                             void *data);
+static void enumerateTopWords(WordsBdd *wb, 
+                              DdNode *match, 
+                              DdNode *scores, 
+                              int k,
+                              WordCallback callback, 
+                              void *data);
+static DdNode *restrictScores(WordsBdd *wb, DdNode *scores, DdNode *bdd);
+static DdNode *getMaxLevel(WordsBdd *wb, DdNode *scores, double *max);
+static DdNode *removeLevel(WordsBdd *wb, DdNode *scores, DdNode *level);
+static void decodeWordCube(char *cube, char *buf);
+static int instantiateCube(int *cube, 
+                           char *buf, 
+                           int i, 
+                           int size, 
+                           WordCallback callback, 
+                           void *data);
+static int setBit(int orig, int bit, int val);
+static int getBit(int i, int bit);
+static DdNode *loadBdd(WordsBdd *wb, char *bddInFile);
+static unsigned char *readDictContainer(WordsBdd *wb,
+                                        char *bddInFile,
+                                        unsigned char *file,
+                                        long fileSize,
+                                        long *rawSize);
+static void writeBddDict(WordsBdd *wb, DdNode *dict, char *bddOutFile);
+static unsigned char *readFile(WordsBdd *wb, char *path, long *size);
+static void putU32(unsigned char *p, unsigned long v);
+static unsigned long getU32(unsigned char *p);
+static unsigned long getChecksum(unsigned char *buf, long size);
+static long getLzBound(long size);
+static long lzCompress(unsigned char *src, long size, unsigned char *dst);
+static long lzPutSequence(unsigned char *dst, 
+                          long op, 
+                          unsigned char *literals, 
+                          long numLiterals,
+                          long matchLen);
+static long lzPutLength(unsigned char *dst, long op, long len);
+static long lzDecompress(unsigned char *src, 
+                         long size, 
+                         unsigned char *dst, 
+                         long capacity);
+static long lzGetLength(unsigned char *src, long size, long *ip, int nibble);
+static int bddIsEmpty(WordsBdd *wb, DdNode *bdd);
+static Crossword readCrossword(WordsBdd *wb, char *crosswordFile, int rawFormat);
+static Crossword readCrosswordRaw(WordsBdd *wb, char *crosswordFile);
+static Crossword readCrosswordDiagram(WordsBdd *wb, char *crosswordFile);
+static void printCrossword(WordsBdd *wb, Crossword *cw);
+static DdNode *getClueBdd(WordsBdd *wb, 
+                          DdNode *dict, 
+                          Crossword *cw, 
+                          Clue *clue,
+                          int clueIndex);
+static int getCoordBddVarIndex(int x, int y, int bit, Crossword *cw);
+static int getClueBddVarIndex(Crossword *cw, Clue *clue, int pos, int bit);
+static int getClueBddEndVarIndex(int clueIndex, int bit);
+static DdNode *getClueBddVar(WordsBdd *wb, 
+                             Crossword *cw, 
+                             Clue *clue, 
+                             int pos, 
+                             int bit);
+static DdNode *getClueBddEndVar(WordsBdd *wb, 
+                                int clueIndex,
+                                int bit);
+static DdNode *encodeCrossword(WordsBdd *wb, 
+                               DdNode *dict, 
+                               Crossword *cw, 
+                               int *order);
+static void solveCrossword(WordsBdd *wb, 
+                           DdNode *dict, 
+                           Crossword *cw,
+                           int topK,
+                           SolutionCallback callback,
+                           void *data);
+static void disableReorderCleanup(WordsBdd *wb, void *unused);
+static int solveCrosswordSplit(WordsBdd *wb, 
+                               DdNode *dict, 
+                               Crossword *cw, 
+                               int *order,
+                               int topK,
+                               SolutionCallback callback,
+                               void *data);
+static void restorePatternCleanup(WordsBdd *wb, void *saved);
+static int addTopSolution(void *top, 
+                          char (*grid)[MAX_WORD_SIZE][MAX_WORD_SIZE], 
+                          double score);
+static int compareTopSolutions(const void *a, const void *b);
+static int enumerateCrosswordSolutions(WordsBdd *wb, 
+                                       DdNode *cwBdd, 
+                                       Crossword *cw,
+                                       int topK,
+                                       SolutionCallback callback,
+                                       void *data);
+static int *getCrossingOrder(Crossword *cw);
+static int cluesCross(Clue *a, Clue *b);
+static int getMostConstrainedClue(WordsBdd *wb, DdNode *dict, Crossword *cw);
+static int enumerateSolutions(WordsBdd *wb, 
+                              DdNode *cwBdd, 
+                              Crossword *cw,
+                              SolutionCallback callback,
+                              void *data);
+static DdNode *getClueScores(WordsBdd *wb, 
+                             DdNode *scores,
+                             Crossword *cw,
+                             Clue *clue,
+                             int clueIndex);
+static DdNode *encodeCrosswordScores(WordsBdd *wb, 
+                                     DdNode *scores, 
+                                     Crossword *cw);
+static int enumerateTopSolutions(WordsBdd *wb, 
+                                 DdNode *cwBdd, 
+                                 DdNode *scores,
+                                 Crossword *cw, 
+                                 int k,
+                                 SolutionCallback callback,
+                                 void *data);
+static DdNode *getSolutionMinterm(WordsBdd *wb, 
+                                  char *cube, 
+                                  int *mask, 
+                                  int size);
+static int *getRelevanceMask(Crossword* cw, int size);
+static int instantiateSolutionCube(int *cube, 
+                                   int *mask, 
+                                   int i, 
+                                   int size, 
+                                   Crossword *cw,
+                                   SolutionCallback callback,
+                                   void *data);
+static void decodeSolution(int *cube, 
+                           int *mask, 
+                           int size, 
+                           Crossword *cw,
+                           char (*grid)[MAX_WORD_SIZE][MAX_WORD_SIZE]);
+static void fillCrossword(WordsBdd *wb, 
+                          DdNode *dict, 
+                          Crossword *cw,
+                          double seconds,
+                          int maxFills,
+                          SolutionCallback callback,
+                          void *data);
+static void freeFillCleanup(WordsBdd *wb, void *fs);
+static int fillSearch(WordsBdd *wb, FillState *fs);
+static int fillTimedOut(FillState *fs);
+static void restoreFillDomains(WordsBdd *wb, FillFrame *saved);
+static void restoreFillCleanup(WordsBdd *wb, void *saved);
+static int forwardCheck(WordsBdd *wb, FillState *fs, int slot);
+static int getFillSlot(FillState *fs);
+static double getFillCount(WordsBdd *wb, FillState *fs, int slot);
+static int reportFill(FillState *fs);
+static int fillUsesWord(FillState *fs, char *word);
+static void getSlotPattern(FillState *fs, Clue *clue, char *pattern);
+static void placeFillWord(FillState *fs, Clue *clue, char *word);
+static int acrossStart(char (*grid)[MAX_WORD_SIZE][MAX_WORD_SIZE], int x, int y);
+static int downStart(char (*grid)[MAX_WORD_SIZE][MAX_WORD_SIZE], int x, int y);
+static int isOccupying(char c);
+static void getAcrossPattern(char (*grid)[MAX_WORD_SIZE][MAX_WORD_SIZE], 
+                             int x,
+                             int y,
+                             char *pattern);
+static void getDownPattern(char (*grid)[MAX_WORD_SIZE][MAX_WORD_SIZE], 
+                           int x,
+                           int y,
+                           char *pattern);
+static void addNamedDict(WordsBdd *wb, char *name, DdNode *bdd);
+static NamedDict *getNamedDict(WordsBdd *wb, char *name);
+static DdNode *evalDictExpr(WordsBdd *wb, char *expr);
+static DdNode *parseDictUnion(WordsBdd *wb, char **pos);
+static DdNode *parseDictIntersect(WordsBdd *wb, char **pos);
+static DdNode *parseDictTerm(WordsBdd *wb, char **pos);
+static void dictExprError(WordsBdd *wb, char *pos, char *msg);
+static void beginPhase(WordsBdd *wb, char *name);
+static void endPhase(WordsBdd *wb);
+static double wallTime();
+static void writeStatsText(WordsBdd *wb, FILE *f);
+static void writeStatsJson(WordsBdd *wb, FILE *f);
+static double getRatio(double num, double denom);
+static long getPeakRss();
+static void checkedRef(WordsBdd *wb, DdNode *node);
+static void resourceLimit(WordsBdd *wb);
+
+#endif